@@ -0,0 +1,56 @@
+#ifndef BLOCKPOOL_HPP
+#define BLOCKPOOL_HPP
+#include <cstddef>
+#include <new>
+#include "config.hpp"
+
+// Free list allocator for objects of a single size (used for cells, which are created
+// and destroyed by the thousands during each evaluation).
+// Each thread has its own free list, so allocations never contend. Memory is taken from
+// the system by chunks of Config::BLOCK_POOL_CHUNK blocks and never given back: the cells
+// of a finished evaluation are recycled by the next evaluations of the same thread.
+// A block freed by another thread than the one which allocated it just moves to the
+// freeing thread's list.
+template <size_t Size> class BlockPool {
+	struct FreeBlock {
+		FreeBlock *next;
+	};
+	static constexpr size_t align = alignof(std::max_align_t);
+	static constexpr size_t blockSize =
+	    ((Size > sizeof(FreeBlock) ? Size : sizeof(FreeBlock)) + align - 1) / align * align;
+
+	FreeBlock *freeList = nullptr;  // trivially destructible: safe to use at thread exit
+
+	static BlockPool &local() {
+		thread_local BlockPool pool;
+		return pool;
+	}
+
+	void refill() {
+		char *chunk = static_cast<char *>(::operator new(blockSize * Config::BLOCK_POOL_CHUNK));
+		for (size_t i = 0; i < Config::BLOCK_POOL_CHUNK; ++i) {
+			auto *b = reinterpret_cast<FreeBlock *>(chunk + i * blockSize);
+			b->next = freeList;
+			freeList = b;
+		}
+	}
+
+ public:
+	static void *allocate() {
+		auto &p = local();
+		if (!p.freeList) p.refill();
+		FreeBlock *b = p.freeList;
+		p.freeList = b->next;
+		return b;
+	}
+
+	static void deallocate(void *ptr) {
+		if (!ptr) return;
+		auto &p = local();
+		auto *b = static_cast<FreeBlock *>(ptr);
+		b->next = p.freeList;
+		p.freeList = b;
+	}
+};
+
+#endif
@@ -1,38 +1,85 @@
 #ifndef CAPTURE_HPP
 #define CAPTURE_HPP
+#include <algorithm>
+#include <array>
+#include <functional>
 #include <vector>
 #include <string>
 #include <deque>
 #include <numeric>
 #include <cmath>
-#include <unordered_set>
 
 struct ClusterTools {
+	// Connected components of cells. clusterOf[i] is the cluster of the ith cell; clusters
+	// are numbered in the order of their first cell.
+	struct ClusterIds {
+		std::vector<size_t> clusterOf;
+		std::vector<size_t> sizes;
+		size_t biggest() const {  // (the first one among the biggest)
+			return std::max_element(sizes.begin(), sizes.end()) - sizes.begin();
+		}
+	};
+
+	// Union-find over the world's list of connections (cc, keyed by pairs of cells).
+	// Connections to cells which are not in cells are ignored.
 	template <typename Cell, typename CC>
-	static std::vector<std::unordered_set<Cell *>> getClusters(
-	    const std::vector<Cell *> &cells, const CC &) {
-		std::unordered_set<Cell *> clusterizedCells;
-		std::vector<std::unordered_set<Cell *>> clusters;
-		for (auto &c : cells) {
-			if (!clusterizedCells.count(c)) {
-				std::unordered_set<Cell *> clust;
-				std::unordered_set<Cell *> toBeAdded = {c};
-				while (toBeAdded.size()) {
-					auto current = *toBeAdded.begin();
-					clust.insert(current);
-					toBeAdded.erase(toBeAdded.begin());
-					for (auto &candidate : current->getConnectedCells()) {
-						if (!clust.count(candidate)) {
-							toBeAdded.insert(candidate);
-						}
-					}
-				}
-				for (auto &clustCell : clust) {
-					clusterizedCells.insert(clustCell);
-				}
-				clusters.push_back(clust);
+	static ClusterIds getClusterIds(const std::vector<Cell *> &cells, const CC &cc) {
+		const size_t n = cells.size();
+		std::vector<std::pair<const Cell *, size_t>> index;  // cells by address
+		index.reserve(n);
+		for (size_t i = 0; i < n; ++i) index.emplace_back(cells[i], i);
+		const auto byAddress = [](const std::pair<const Cell *, size_t> &a,
+		                          const std::pair<const Cell *, size_t> &b) {
+			return std::less<const Cell *>()(a.first, b.first);
+		};
+		std::sort(index.begin(), index.end(), byAddress);
+		const auto indexOf = [&](const Cell *c) {
+			auto it = std::lower_bound(index.begin(), index.end(),
+			                           std::make_pair(c, static_cast<size_t>(0)), byAddress);
+			return (it != index.end() && it->first == c) ? it->second : n;
+		};
+		std::vector<size_t> parent(n), rootSize(n, 1);
+		std::iota(parent.begin(), parent.end(), 0);
+		const auto find = [&](size_t i) {
+			while (parent[i] != i) {  // path halving
+				parent[i] = parent[parent[i]];
+				i = parent[i];
+			}
+			return i;
+		};
+		for (const auto &con : cc) {
+			size_t a = indexOf(con.first.first), b = indexOf(con.first.second);
+			if (a == n || b == n) continue;
+			a = find(a);
+			b = find(b);
+			if (a == b) continue;
+			if (rootSize[a] < rootSize[b]) std::swap(a, b);
+			parent[b] = a;
+			rootSize[a] += rootSize[b];
+		}
+		ClusterIds res;
+		res.clusterOf.resize(n);
+		std::vector<size_t> idOfRoot(n, n);
+		for (size_t i = 0; i < n; ++i) {
+			const size_t r = find(i);
+			if (idOfRoot[r] == n) {
+				idOfRoot[r] = res.sizes.size();
+				res.sizes.push_back(0);
 			}
+			res.clusterOf[i] = idOfRoot[r];
+			++res.sizes[idOfRoot[r]];
 		}
+		return res;
+	}
+
+	// cells of each cluster, in the order of cells
+	template <typename Cell, typename CC>
+	static std::vector<std::vector<Cell *>> getClusters(const std::vector<Cell *> &cells,
+	                                                    const CC &cc) {
+		const auto ids = getClusterIds(cells, cc);
+		std::vector<std::vector<Cell *>> clusters(ids.sizes.size());
+		for (size_t k = 0; k < clusters.size(); ++k) clusters[k].reserve(ids.sizes[k]);
+		for (size_t i = 0; i < cells.size(); ++i) clusters[ids.clusterOf[i]].push_back(cells[i]);
 		return clusters;
 	}
 
@@ -86,21 +133,90 @@ struct ClusterTools {
 	static vector<Cell *> getBiggestCluster(const vector<Cell *> &cells, const CC &cc) {
 		vector<Cell *> biggestCluster;
 		if (cells.size() > 0) {
-			auto clusters = getClusters(cells, cc);
-			size_t biggestClusterId = 0;
-			size_t biggestClusterSize = clusters[biggestClusterId].size();
-			for (size_t i = 1; i < clusters.size(); ++i) {
-				if (clusters[i].size() > biggestClusterSize) {
-					biggestClusterSize = clusters[i].size();
-					biggestClusterId = i;
-				}
-			}
-			biggestCluster.reserve(clusters[biggestClusterId].size());
-			for (auto &c : clusters[biggestClusterId]) biggestCluster.push_back(c);
+			const auto ids = getClusterIds(cells, cc);
+			const size_t b = ids.biggest();
+			biggestCluster.reserve(ids.sizes[b]);
+			for (size_t i = 0; i < cells.size(); ++i)
+				if (ids.clusterOf[i] == b) biggestCluster.push_back(cells[i]);
 		}
 		return biggestCluster;
 	}
 
+	// Indices {i < j} of two of the farthest apart points, on their convex hull (monotone
+	// chain) with rotating calipers: O(n log n). Ties are broken arbitrarily.
+	static std::pair<size_t, size_t> farthestPairInPlane(
+	    const std::vector<std::array<double, 2>> &p) {
+		const size_t n = p.size();
+		if (n < 2) return {0, 0};
+		std::vector<size_t> order(n);
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return p[a] < p[b]; });
+		const auto cross = [&](size_t o, size_t a, size_t b) {
+			return (p[a][0] - p[o][0]) * (p[b][1] - p[o][1]) -
+			       (p[a][1] - p[o][1]) * (p[b][0] - p[o][0]);
+		};
+		std::vector<size_t> hull(2 * n);  // counterclockwise, without collinear points
+		size_t k = 0;
+		for (size_t i = 0; i < n; ++i) {
+			while (k >= 2 && cross(hull[k - 2], hull[k - 1], order[i]) <= 0) --k;
+			hull[k++] = order[i];
+		}
+		for (size_t i = n - 1, lower = k + 1; i-- > 0;) {
+			while (k >= lower && cross(hull[k - 2], hull[k - 1], order[i]) <= 0) --k;
+			hull[k++] = order[i];
+		}
+		hull.resize(k - 1);  // (the first point was added again)
+		const auto sqDist = [&](size_t a, size_t b) {
+			const double dx = p[a][0] - p[b][0], dy = p[a][1] - p[b][1];
+			return dx * dx + dy * dy;
+		};
+		const size_t h = hull.size();
+		std::pair<size_t, size_t> best = {hull[0], hull[h > 1 ? 1 : 0]};
+		double bestSqDist = sqDist(best.first, best.second);
+		const auto consider = [&](size_t a, size_t b) {
+			const double d = sqDist(a, b);
+			if (d > bestSqDist) {
+				bestSqDist = d;
+				best = {a, b};
+			}
+		};
+		if (h > 2) {
+			for (size_t i = 0, j = 1; i < h; ++i) {
+				const size_t next = (i + 1) % h;
+				while (cross(hull[i], hull[next], hull[(j + 1) % h]) >
+				       cross(hull[i], hull[next], hull[j]))
+					j = (j + 1) % h;
+				consider(hull[i], hull[j]);
+				consider(hull[next], hull[j]);
+			}
+		}
+		if (best.first > best.second) std::swap(best.first, best.second);
+		return best;
+	}
+
+	// positions of the cells in a plane of normal zAxis, in an orthonormal basis of it
+	template <typename Cell>
+	static std::vector<std::array<double, 2>> projectOnPlane(const std::vector<Cell *> &cells,
+	                                                          const MecaCell::Vec &zAxis) {
+		const auto u = zAxis.ortho().normalized();
+		const auto v = zAxis.cross(u).normalized();
+		std::vector<std::array<double, 2>> projected;
+		projected.reserve(cells.size());
+		for (auto &c : cells)
+			projected.push_back({{c->getPosition().dot(u), c->getPosition().dot(v)}});
+		return projected;
+	}
+
+	// Indices {i < j} of two of the farthest apart cells once projected on their best
+	// fitting plane, as for the main axis of a capture: O(n log n) (see
+	// farthestPairInPlane). It is the farthest pair in space when the cells lie in a
+	// plane, and may be a shorter one otherwise. Ties are broken arbitrarily.
+	template <typename Cell>
+	static std::pair<size_t, size_t> farthestPair(const std::vector<Cell *> &cells) {
+		if (cells.size() < 2) return {0, 0};
+		return farthestPairInPlane(projectOnPlane(cells, fitPlane(cells).second));
+	}
+
 	template <typename Cell>
 	static std::pair<MecaCell::Vec, MecaCell::Vec> fitPlane(vector<Cell *> cells) {
 		// returns the best fitting plane {offset, normal} (min squared dist)
@@ -156,32 +272,43 @@ struct ClusterTools {
 		};
 	}
 
-	template <int FinalW = 30, int FinalH = 30, typename Cell>
-	static std::array<std::array<double, FinalW>, FinalH> getMatrixCapture(
-	    const vector<Cell *> &cells, bool binary = false, double maxWidth = 0.0) {
-		// we oversample and downscale
-		// we want W & H to be a multiple of FinalW & FinalH
-		constexpr double overSamplingCoef = 3.0;
-		constexpr int W = overSamplingCoef * FinalW;
-		constexpr int H = overSamplingCoef * FinalH;
+	// Cells of a capture once projected on their best fitting plane, main axis along x,
+	// as disks in a W x H grid of subpixels whose (i, j) is centered on
+	// ((i + 0.5) * gridSize, (j + 0.5) * gridSize).
+	struct CaptureLayout {
+		struct Disk {
+			double x, y, radius;
+		};
+		double gridSize = 1.0;
+		std::vector<Disk> disks;
+
+		// is the center of subpixel (i, j) in d?
+		bool covers(const Disk &d, int i, int j) const {
+			double ipos = (static_cast<double>(i) + 0.5) * gridSize;
+			double jpos = (static_cast<double>(j) + 0.5) * gridSize;
+			return sqrt(pow(ipos - d.x, 2) + pow(jpos - d.y, 2)) <= d.radius;
+		}
+	};
 
-		std::array<std::array<double, H>, W> overSampledCapture = {};
+	static constexpr int CAPTURE_OVERSAMPLING = 3;  // subpixels per pixel, in each direction
+
+	template <int W, int H, typename Cell>
+	static CaptureLayout getCaptureLayout(const vector<Cell *> &cells, double maxWidth) {
 		auto bestPlane = fitPlane(cells);
 		const auto &centroid = bestPlane.first;
 		const auto &zAxis = bestPlane.second;
 
-		// finding main axis
+		// finding main axis: the longest distance between two cells in the plane
 		MecaCell::Vec xAxis(1, 0, 0);
 		double sql = 0;
-		for (size_t i = 0; i < cells.size(); ++i) {
-			for (size_t j = 0; j < cells.size(); ++j) {
-				auto axis = cells[j]->getPosition() - cells[i]->getPosition();
-				auto projectedAxis = axis - zAxis * axis.dot(zAxis);
-				auto l = projectedAxis.sqlength();
-				if (l > sql) {
-					sql = l;
-					xAxis = projectedAxis;
-				}
+		if (cells.size() > 1) {
+			const auto ends = farthestPairInPlane(projectOnPlane(cells, zAxis));
+			auto axis = cells[ends.second]->getPosition() - cells[ends.first]->getPosition();
+			auto projectedAxis = axis - zAxis * axis.dot(zAxis);
+			auto l = projectedAxis.sqlength();
+			if (l > sql) {
+				sql = l;
+				xAxis = projectedAxis;
 			}
 		}
 		double captWidth = maxWidth;
@@ -189,45 +316,33 @@ struct ClusterTools {
 			// auto scale, we asjust the so that all cells fit
 			captWidth = sqrt(sql);
 		}
-		const double gridSize = (captWidth / static_cast<double>(W)) + 1.0;
+		CaptureLayout layout;
+		layout.gridSize = (captWidth / static_cast<double>(W)) + 1.0;
 		xAxis.normalize();
 		auto yAxis = xAxis.cross(zAxis).normalized();
 		// we align the longest axis along the bottomleft-upright diagonal
-		// and we project each cell's bounding box in this plane
+		// and we project each cell in this plane
+		layout.disks.reserve(cells.size());
 		for (auto &c : cells) {
 			auto OC = c->getPosition() - centroid;
-			double cellCenter_x = static_cast<double>(W / 2) * gridSize + OC.dot(xAxis);
-			double cellCenter_y = static_cast<double>(H / 2) * gridSize + OC.dot(yAxis);
-			int cellCenter_ix = floor(cellCenter_x / gridSize);
-			int cellCenter_iy = floor(cellCenter_y / gridSize);
-			double radius = c->getBoundingBoxRadius();
-			int intRadius = ceil(radius / gridSize) + 1;
-			for (int i = max(0, cellCenter_ix - intRadius);
-			     i < min((int)W, cellCenter_ix + intRadius); ++i) {
-				for (int j = max(0, cellCenter_iy - intRadius);
-				     j < min((int)H, cellCenter_iy + intRadius); ++j) {
-					double ipos = (static_cast<double>(i) + 0.5) * gridSize;
-					double jpos = (static_cast<double>(j) + 0.5) * gridSize;
-					double dist = sqrt(pow(ipos - cellCenter_x, 2) + pow(jpos - cellCenter_y, 2));
-					double intensity = 1.0;
-					if (dist > radius) intensity = 0.0;
-					overSampledCapture[i][j] += intensity;
-				}
-			}
+			layout.disks.push_back(
+			    {static_cast<double>(W / 2) * layout.gridSize + OC.dot(xAxis),
+			     static_cast<double>(H / 2) * layout.gridSize + OC.dot(yAxis),
+			     static_cast<double>(c->getBoundingBoxRadius())});
 		}
-		// downscaling using average
+		return layout;
+	}
+
+	// Pixels from the number of their covered subpixels: average coverage, or whether
+	// more than half of them are covered.
+	template <int FinalW, int FinalH>
+	static std::array<std::array<double, FinalW>, FinalH> downscaleCapture(
+	    const std::array<std::array<int, FinalW>, FinalH> &covered, bool binary) {
 		std::array<std::array<double, FinalW>, FinalH> capture = {};
 		for (int l = 0; l < FinalH; ++l) {
 			for (int c = 0; c < FinalW; ++c) {
-				double avg = 0;
-				for (int x = c * overSamplingCoef; x < c * overSamplingCoef + overSamplingCoef;
-				     ++x) {
-					for (int y = l * overSamplingCoef; y < l * overSamplingCoef + overSamplingCoef;
-					     ++y) {
-						avg += overSampledCapture[x][y];
-					}
-				}
-				avg /= (overSamplingCoef * overSamplingCoef);
+				double avg = covered[l][c] / static_cast<double>(CAPTURE_OVERSAMPLING *
+				                                                 CAPTURE_OVERSAMPLING);
 				if (binary)
 					capture[l][c] = avg > 0.5 ? 1 : 0;  // binarisation
 				else
@@ -236,6 +351,55 @@ struct ClusterTools {
 		}
 		return capture;
 	}
+
+	// Image of the cells projected on their best fitting plane, main axis along x (see
+	// getCaptureLayout). Each pixel is the average coverage of its oversampled subpixels
+	// (a subpixel is covered by a cell when its center is in the cell's disk). Disks are
+	// filled row by row, from the span of each row, and counted directly in the final
+	// pixels.
+	template <int FinalW = 30, int FinalH = 30, typename Cell>
+	static std::array<std::array<double, FinalW>, FinalH> getMatrixCapture(
+	    const vector<Cell *> &cells, bool binary = false, double maxWidth = 0.0) {
+		constexpr int overSampling = CAPTURE_OVERSAMPLING;
+		constexpr int W = overSampling * FinalW;
+		constexpr int H = overSampling * FinalH;
+		const auto layout = getCaptureLayout<W, H>(cells, maxWidth);
+		const double gridSize = layout.gridSize;
+		std::array<std::array<int, FinalW>, FinalH> covered = {};  // subpixels, by pixel
+		for (const auto &d : layout.disks) {
+			int cellCenter_ix = floor(d.x / gridSize);
+			int cellCenter_iy = floor(d.y / gridSize);
+			int intRadius = ceil(d.radius / gridSize) + 1;
+			const int iMin = max(0, cellCenter_ix - intRadius);
+			const int iMax = min(W, cellCenter_ix + intRadius);
+			const int jMin = max(0, cellCenter_iy - intRadius);
+			const int jMax = min(H, cellCenter_iy + intRadius);
+			if (jMin >= jMax) continue;
+			const auto inside = [&](int i, int j) { return layout.covers(d, i, j); };
+			for (int i = iMin; i < iMax; ++i) {
+				// span of the row, whose ends are then settled by the exact test
+				const double dx = (static_cast<double>(i) + 0.5) * gridSize - d.x;
+				const double halfSpan = sqrt(max(0.0, d.radius * d.radius - dx * dx));
+				const double yLo = (d.y - halfSpan) / gridSize - 0.5;
+				const double yHi = (d.y + halfSpan) / gridSize - 0.5;
+				int jLo = max(jMin, static_cast<int>(ceil(yLo)));
+				int jHi = min(jMax - 1, static_cast<int>(floor(yHi)));
+				if (jLo > jHi) {  // then at most the subpixel closest to the center
+					jLo = jHi = min(jMax - 1, max(jMin, cellCenter_iy));
+					if (!inside(i, jLo)) continue;
+				}
+				while (jLo > jMin && inside(i, jLo - 1)) --jLo;
+				while (jLo <= jHi && !inside(i, jLo)) ++jLo;
+				while (jHi < jMax - 1 && inside(i, jHi + 1)) ++jHi;
+				while (jHi >= jLo && !inside(i, jHi)) --jHi;
+				if (jLo > jHi) continue;
+				for (int l = jLo / overSampling; l <= jHi / overSampling; ++l)
+					covered[l][i / overSampling] += min(jHi, l * overSampling + overSampling - 1) -
+					                                max(jLo, l * overSampling) + 1;
+			}
+		}
+		return downscaleCapture<FinalW, FinalH>(covered, binary);
+	}
 	template <typename T>
 	static std::string captMatrixToString(const T &capture, bool trueColorEnabled = false) {
 		const std::array<std::string, 8> pixels = {
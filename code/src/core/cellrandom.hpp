@@ -0,0 +1,37 @@
+#ifndef CELLRANDOM_HPP
+#define CELLRANDOM_HPP
+#include <array>
+#include <cstdint>
+#include <limits>
+
+// Counter based random generator (SplitMix64): the nth number of a stream is a hash of
+// (key, n), so the whole state fits in two words instead of the ~5KB of an mt19937.
+// It satisfies UniformRandomBitGenerator and is used with the std distributions.
+class CellRandom {
+	uint64_t key = 0;
+	uint64_t counter = 0;
+
+	static uint64_t mix(uint64_t z) {
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+
+ public:
+	using result_type = uint64_t;
+
+	CellRandom() {}
+	explicit CellRandom(uint64_t k) : key(mix(k)) {}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+	result_type operator()() { return mix(key + (++counter) * 0x9e3779b97f4a7c15ULL); }
+
+	// raw state, for snapshots
+	std::array<uint64_t, 2> getState() const { return {{key, counter}}; }
+	void setState(const std::array<uint64_t, 2>& s) {
+		key = s[0];
+		counter = s[1];
+	}
+};
+#endif
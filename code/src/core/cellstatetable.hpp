@@ -0,0 +1,110 @@
+#ifndef CELLSTATETABLE_HPP
+#define CELLSTATETABLE_HPP
+#include <array>
+#include <vector>
+#include <cstddef>
+#include "config.hpp"
+
+enum class CycleStep { quiescent, growing };
+
+// Biological state of cells (nutrients, morphogens, age, cycle step) as structure of
+// arrays, so that the environment passes of a scenario stream through contiguous memory.
+// A cell owns one slot of a table (Cell::slot) and a row is valid as long as the cell
+// lives. Removing a cell only marks its slot; compact() then packs the live rows back
+// together, in order, and tells each moved cell its new slot.
+// Cells created outside of any scenario (stem cells, copies...) live in a per-thread
+// detached table until a scenario adopts them.
+template <typename Cell> struct CellStateTable {
+	std::array<std::vector<double>, Config::NB_NUTRIENTS> nutrientLevel, sensedNutrients;
+	std::array<std::vector<double>, Config::NB_MORPHOGENS> morphogensProduction,
+	    sensedMorphogens;
+	std::vector<double> age;
+	std::vector<CycleStep> currentStep;
+	std::vector<Cell *> owner;  // nullptr for slots of removed cells
+	size_t nbRemoved = 0;
+
+	size_t size() const { return owner.size(); }
+
+	// never destroyed, so cells can still leave it at thread exit
+	static CellStateTable &detached() {
+		thread_local CellStateTable *t = new CellStateTable();
+		return *t;
+	}
+
+	// appends a zeroed row for c and returns its slot
+	size_t add(Cell *c) {
+		for (auto &v : nutrientLevel) v.push_back(0.0);
+		for (auto &v : sensedNutrients) v.push_back(0.0);
+		for (auto &v : morphogensProduction) v.push_back(0.0);
+		for (auto &v : sensedMorphogens) v.push_back(0.0);
+		age.push_back(0.0);
+		currentStep.push_back(CycleStep::quiescent);
+		owner.push_back(c);
+		return owner.size() - 1;
+	}
+
+	// appends a copy of row s of table t for c and returns its slot
+	size_t addCopy(Cell *c, const CellStateTable &t, size_t s) {
+		const size_t res = add(c);
+		copyRow(t, s, res);
+		return res;
+	}
+
+	void remove(size_t s) {
+		owner[s] = nullptr;
+		++nbRemoved;
+		// tables that are not compacted by a scenario must not grow forever
+		if (nbRemoved > Config::CELL_STATE_TABLE_SLACK && nbRemoved * 2 > size()) compact();
+	}
+
+	// moves c's row from its current table to this one
+	void adopt(Cell *c) {
+		auto *from = c->stateTable;
+		if (from == this) return;
+		const size_t s = c->slot;
+		c->slot = addCopy(c, *from, s);
+		c->stateTable = this;
+		from->remove(s);
+	}
+
+	void compact() {
+		if (nbRemoved == 0) return;
+		size_t n = 0;
+		for (size_t s = 0; s < size(); ++s) {
+			if (!owner[s]) continue;
+			if (n != s) {
+				copyRow(*this, s, n);
+				owner[n] = owner[s];
+				owner[n]->slot = n;
+			}
+			++n;
+		}
+		resize(n);
+		nbRemoved = 0;
+	}
+
+ private:
+	void copyRow(const CellStateTable &t, size_t from, size_t to) {
+		for (size_t i = 0; i < Config::NB_NUTRIENTS; ++i) {
+			nutrientLevel[i][to] = t.nutrientLevel[i][from];
+			sensedNutrients[i][to] = t.sensedNutrients[i][from];
+		}
+		for (size_t i = 0; i < Config::NB_MORPHOGENS; ++i) {
+			morphogensProduction[i][to] = t.morphogensProduction[i][from];
+			sensedMorphogens[i][to] = t.sensedMorphogens[i][from];
+		}
+		age[to] = t.age[from];
+		currentStep[to] = t.currentStep[from];
+	}
+
+	void resize(size_t n) {
+		for (auto &v : nutrientLevel) v.resize(n);
+		for (auto &v : sensedNutrients) v.resize(n);
+		for (auto &v : morphogensProduction) v.resize(n);
+		for (auto &v : sensedMorphogens) v.resize(n);
+		age.resize(n);
+		currentStep.resize(n);
+		owner.resize(n);
+	}
+};
+#endif
@@ -1,6 +1,7 @@
 #ifndef CONFIG_HPP
 #define CONFIG_HPP
 #include <array>
+#include <cstddef>
 #define WATER 0
 #define LIGHT 1
 struct Config {
@@ -50,5 +51,22 @@ struct Config {
 	static constexpr double FIRST_NUTRIENT_SOURCE_THRESHOLD = 100.0;
 	static constexpr double SUN_INTENSITY = 1.0;
 	static constexpr double MAX_LIGHT_THRESHOLD = 400.0;
+
+	// intra-simulation parallelism
+	static constexpr size_t CELL_PHASE_CHUNK = 32;
+	static constexpr size_t MIN_CELLS_FOR_PARALLEL_PHASE = 128;
+
+	// sleeping cells (--sleep)
+	static constexpr unsigned int SLEEP_DELAY = 30;  // steps at rest before falling asleep
+	static constexpr double SLEEP_MAX_SPEED = 0.05;
+	static constexpr double SLEEP_MAX_FORCE = 0.5;
+	static constexpr double SLEEP_INPUT_TOLERANCE = 0.01;
+
+	// stem cell pre-screen (--prescreen)
+	static constexpr unsigned int PRESCREEN_STEPS = 300;  // controller only, for inertia
+
+	// memory
+	static constexpr size_t BLOCK_POOL_CHUNK = 64;  // cells allocated at once by a pool
+	static constexpr size_t CELL_STATE_TABLE_SLACK = 64;  // removed rows before compaction
 };
 #endif
@@ -0,0 +1,84 @@
+#ifndef CONNECTIONGRAPH_HPP
+#define CONNECTIONGRAPH_HPP
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstddef>
+#include "config.hpp"
+
+// Flat (structure of arrays) copy of the world's cell-cell connections.
+// Edge e links cells first[e] and second[e] (indices in the cells vector given to
+// refresh). For each cell, incidentEdges[incidentStart[i] .. incidentStart[i+1][ lists
+// the edges it belongs to, by increasing index of the other cell: the world's connections
+// are hashed by address, so their order would otherwise depend on where cells were
+// allocated (and a restored scenario would not sum fluxes in the same order).
+struct ConnectionGraph {
+	std::vector<size_t> first, second;
+	std::vector<double> adhArea, centersDist, adhCoef;
+	std::vector<size_t> incidentStart, incidentEdges;
+	std::vector<const void *> links;  // the world's connection behind each edge
+
+	size_t size() const { return first.size(); }
+
+	// Cells must carry a graphIndex member, which is (re)assigned here.
+	// Connections only come and go with contacts, divisions and deaths. While the world
+	// lists the same connections, between cells of the same indices and in the same
+	// order, only their geometry is copied again; the edges and incidence lists are
+	// rebuilt otherwise.
+	template <typename Cell, typename CC>
+	void refresh(const std::vector<Cell *> &cells, const CC &connections) {
+		for (size_t i = 0; i < cells.size(); ++i) cells[i]->graphIndex = i;
+		if (incidentStart.size() == cells.size() + 1 && connections.size() == size()) {
+			size_t e = 0;
+			for (const auto &con : connections) {
+				if (links[e] != &*con.second || first[e] != con.first.first->graphIndex ||
+				    second[e] != con.first.second->graphIndex)
+					break;
+				adhArea[e] = con.second->adhArea;
+				centersDist[e] = con.second->centersDist;
+				adhCoef[e] = con.second->adhCoef;
+				++e;
+			}
+			if (e == size()) return;
+		}
+		rebuild(cells.size(), connections);
+	}
+
+ private:
+	template <typename CC> void rebuild(size_t nbCells, const CC &connections) {
+		first.clear();
+		second.clear();
+		adhArea.clear();
+		centersDist.clear();
+		adhCoef.clear();
+		links.clear();
+		for (const auto &con : connections) {
+			first.push_back(con.first.first->graphIndex);
+			second.push_back(con.first.second->graphIndex);
+			adhArea.push_back(con.second->adhArea);
+			centersDist.push_back(con.second->centersDist);
+			adhCoef.push_back(con.second->adhCoef);
+			links.push_back(&*con.second);
+		}
+		// incidence lists (counting sort on endpoints), then ordered by neighbour
+		incidentStart.assign(nbCells + 1, 0);
+		for (size_t e = 0; e < size(); ++e) {
+			++incidentStart[first[e] + 1];
+			++incidentStart[second[e] + 1];
+		}
+		for (size_t i = 0; i < nbCells; ++i) incidentStart[i + 1] += incidentStart[i];
+		incidentEdges.resize(2 * size());
+		std::vector<size_t> fill(incidentStart.begin(), incidentStart.end() - 1);
+		for (size_t e = 0; e < size(); ++e) {
+			incidentEdges[fill[first[e]]++] = e;
+			incidentEdges[fill[second[e]]++] = e;
+		}
+		for (size_t i = 0; i < nbCells; ++i) {
+			auto other = [&](size_t e) { return first[e] == i ? second[e] : first[e]; };
+			std::sort(incidentEdges.begin() + incidentStart[i],
+			          incidentEdges.begin() + incidentStart[i + 1],
+			          [&](size_t a, size_t b) { return other(a) < other(b); });
+		}
+	}
+};
+#endif
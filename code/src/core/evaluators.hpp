@@ -4,19 +4,22 @@
 #include <cmath>
 #include <numeric>
 #include <deque>
+#include <limits>
+#include <sstream>
 #include <mecacell/mecacell.h>
 #include "config.hpp"
+#include "scenariooptions.hpp"
 #include "../external/grgen/common.h"
 #include "capture.hpp"
+#include "observers.hpp"
 
 template <class Scenario> struct ComplexMorphologyEvaluator {
 	const std::string name = "complexMorpho";
-	int argc;
-	char **argv;
+	ScenarioOptions options;
 
-	ComplexMorphologyEvaluator(int c, char **v) : argc(c), argv(v) {}
+	ComplexMorphologyEvaluator(int c, char **v) : options(ScenarioOptions::parse(c, v)) {}
 
-	template <typename Cell> double computeSphericity(const unordered_set<Cell *> clust) {
+	template <typename Cell> double computeSphericity(const std::vector<Cell *> &clust) {
 		MecaCell::Grid<Cell *> grid(MecaCell::DEFAULT_CELL_RADIUS / 3.0);
 		for (auto &c : clust) grid.insert(c);
 		auto s = grid.computeSphericity();
@@ -60,18 +63,19 @@ template <class Scenario> struct ComplexMorphologyEvaluator {
 		double longestProj3 = 0;
 		double longestDist = longestAxis.length();
 		if (longestDist > 0) {
+			// the longest projection of a pair is the extent of the projections
 			MecaCell::Vec axis2 = longestAxis.ortho().normalized();
 			MecaCell::Vec axis3 = longestAxis.cross(axis2).normalized();
-			for (size_t i = 0; i < biggestClusterSize; ++i) {
-				for (size_t j = i + 1; j < biggestClusterSize; ++j) {
-					auto AB =
-					    biggestClusterVec[i]->getPosition() - biggestClusterVec[j]->getPosition();
-					auto proj2 = fabs(AB.dot(axis2));
-					auto proj3 = fabs(AB.dot(axis3));
-					if (longestProj2 < proj2) longestProj2 = proj2;
-					if (longestProj3 < proj3) longestProj3 = proj3;
-				}
+			double min2 = biggestClusterVec[0]->getPosition().dot(axis2), max2 = min2;
+			double min3 = biggestClusterVec[0]->getPosition().dot(axis3), max3 = min3;
+			for (auto &c : biggestClusterVec) {
+				min2 = std::min(min2, c->getPosition().dot(axis2));
+				max2 = std::max(max2, c->getPosition().dot(axis2));
+				min3 = std::min(min3, c->getPosition().dot(axis3));
+				max3 = std::max(max3, c->getPosition().dot(axis3));
 			}
+			longestProj2 = max2 - min2;
+			longestProj3 = max3 - min3;
 		}
 		double normalizedNbCells = ClusterTools::sqAsympt(
 		    biggestClusterSize, 0.002);  // counts less after 1000 cells.
@@ -84,26 +88,15 @@ template <class Scenario> struct ComplexMorphologyEvaluator {
 		return {{normalizedNbCells, sphericity, ratioProj2, ratioProj3}};
 	}
 
-	template <typename Cell> MecaCell::Vec getLongestDistance(std::vector<Cell *> cells) {
-		MecaCell::Vec longest(0, 0, 0);
-		double sql = 0;
-		for (size_t i = 0; i < cells.size(); ++i) {
-			for (size_t j = 0; j < cells.size(); ++j) {
-				auto axis = cells[i]->getPosition() - cells[j]->getPosition();
-				auto l = axis.sqlength();
-				if (l > sql) {
-					sql = l;
-					longest = axis;
-				}
-			}
-		}
-		return longest;
+	template <typename Cell> MecaCell::Vec getLongestDistance(const std::vector<Cell *> &cells) {
+		if (cells.size() < 2) return MecaCell::Vec(0, 0, 0);
+		const auto ends = ClusterTools::farthestPair(cells);
+		return cells[ends.first]->getPosition() - cells[ends.second]->getPosition();
 	}
 
 	template <typename Individu> void operator()(Individu &ind) {
-		Scenario sc;
-		sc.setStemCell(new typename Scenario::CellType(ind.dna));
-		sc.init(argc, argv);
+		auto &sc =
+		    Scenario::threadLocal(new typename Scenario::CellType(ind.dna), options);
 		while (!sc.finished()) {
 			sc.loop();
 		}
@@ -116,10 +109,9 @@ template <class Scenario> struct ComplexMorphologyEvaluator {
 
 template <class Scenario> struct CaptureEvaluator {
 	const std::string name = "Capture";
-	int argc;
-	char **argv;
+	ScenarioOptions options;
 
-	CaptureEvaluator(int c, char **v) : argc(c), argv(v) {}
+	CaptureEvaluator(int c, char **v) : options(ScenarioOptions::parse(c, v)) {}
 	template <typename T>
 	static std::vector<std::vector<double>> captMatrixTofootprint(const T &capture) {
 		std::vector<std::vector<double>> res;
@@ -136,9 +128,8 @@ template <class Scenario> struct CaptureEvaluator {
 	}
 
 	template <typename Individu> void operator()(Individu &ind) {
-		Scenario sc;
-		sc.setStemCell(new typename Scenario::CellType(ind.dna));
-		sc.init(argc, argv);
+		auto &sc =
+		    Scenario::threadLocal(new typename Scenario::CellType(ind.dna), options);
 		while (!sc.finished()) {
 			sc.loop();
 		}
@@ -164,10 +155,9 @@ template <class Scenario> struct CaptureEvaluator {
 
 template <class Scenario> struct EnergyNoveltyEvaluator {
 	const std::string name = "EnergyAndNovelty";
-	int argc;
-	char **argv;
+	ScenarioOptions options;
 
-	EnergyNoveltyEvaluator(int c, char **v) : argc(c), argv(v) {}
+	EnergyNoveltyEvaluator(int c, char **v) : options(ScenarioOptions::parse(c, v)) {}
 	template <typename T>
 	static std::vector<std::vector<double>> captMatrixTofootprint(const T &capture) {
 		std::vector<std::vector<double>> res;
@@ -184,9 +174,8 @@ template <class Scenario> struct EnergyNoveltyEvaluator {
 	}
 
 	template <typename Individu> void operator()(Individu &ind) {
-		Scenario sc;
-		sc.setStemCell(new typename Scenario::CellType(ind.dna));
-		sc.init(argc, argv);
+		auto &sc =
+		    Scenario::threadLocal(new typename Scenario::CellType(ind.dna), options);
 		while (!sc.finished()) {
 			sc.loop();
 		}
@@ -213,15 +202,13 @@ template <class Scenario> struct EnergyNoveltyEvaluator {
 };
 template <class Scenario> struct EnergyEvaluator {
 	const std::string name = "Energy";
-	int argc;
-	char **argv;
+	ScenarioOptions options;
 
-	EnergyEvaluator(int c, char **v) : argc(c), argv(v) {}
+	EnergyEvaluator(int c, char **v) : options(ScenarioOptions::parse(c, v)) {}
 
 	template <typename Individu> void operator()(Individu &ind) {
-		Scenario sc;
-		sc.setStemCell(new typename Scenario::CellType(ind.dna));
-		sc.init(argc, argv);
+		auto &sc =
+		    Scenario::threadLocal(new typename Scenario::CellType(ind.dna), options);
 		while (!sc.finished()) {
 			sc.loop();
 		}
@@ -246,52 +233,100 @@ template <class Scenario> struct EnergyEvaluator {
 };
 template <class Scenario> struct SurvivalEvaluator {
 	const std::string name = "Survival";
-	int argc;
-	char **argv;
+	ScenarioOptions options;
 
-	SurvivalEvaluator(int c, char **v) : argc(c), argv(v) {}
+	SurvivalEvaluator(int c, char **v) : options(ScenarioOptions::parse(c, v)) {}
 
 	template <typename Individu> void operator()(Individu &ind) {
-		Scenario sc;
-		sc.setStemCell(new typename Scenario::CellType(ind.dna));
-		sc.init(argc, argv);
-		size_t maxC = 1;
-		while (!sc.finished()) {
+		ind.evalStats.clear();
+		ind.evalState.clear();
+		(*this)(ind, std::numeric_limits<double>::infinity());
+	}
+
+	// Staged evaluation (see GAGA::GA::setStagedEvaluation): the simulation goes on from
+	// the snapshot of the previous call, if any, until horizon. The survival time reached
+	// so far is a lower bound of the final one. Returns true once the simulation is over.
+	// Scenario::restore is exact, so the final results are those of a single call. With
+	// options.replay, each call simulates again from the start instead (same results, no
+	// speedup: only to check snapshots). A snapshot which cannot be restored falls back to
+	// a full evaluation.
+	template <typename Individu> bool operator()(Individu &ind, double horizon) {
+		auto &sc =
+		    Scenario::threadLocal(new typename Scenario::CellType(ind.dna), options);
+		bool firstCall = ind.evalState.empty() || options.replay;
+		if (!firstCall) {
+			std::istringstream snapshot(ind.evalState);
+			if (!sc.restore(snapshot)) {  // (sc is back at its stem cell)
+				ind.evalStats.clear();
+				ind.evalState.clear();
+				horizon = std::numeric_limits<double>::infinity();
+				firstCall = true;
+			}
+		}
+		const double t0 = sc.simTime;
+		size_t maxC = std::max<size_t>(1, ind.evalStats["maxCells"]);
+		while (!sc.finished() && sc.simTime < horizon) {
 			sc.loop();
 			if (sc.getWorld().cells.size() > maxC) maxC = sc.getWorld().cells.size();
 		}
-		sc.terminate();
+		const bool over = sc.finished();
+		// plants still alive at the same horizon are ranked on their scarcest reserve
+		double promise = std::numeric_limits<double>::infinity();
+		for (size_t n = 0; n < Config::NB_NUTRIENTS; ++n) {
+			double stock = 0.0;
+			for (const auto &c : sc.getWorld().cells) stock += c->nutrientLevel(n);
+			promise = std::min(promise, stock);
+		}
+		ind.evalStats["promise"] = sc.getWorld().cells.empty() ? 0.0 : promise;
+		ind.evalStats["maxCells"] = maxC;
+		if (options.prescreen && firstCall) {
+			const auto &ps = sc.prescreenResult;
+			ind.evalStats["prescreenDead"] = ps.diedAtOnce;
+			ind.evalStats["prescreenInert"] = ps.predictedInert;
+			ind.evalStats["prescreenTime"] = ps.time;
+		}
+		if (options.prescreen)  // was the guess right? (only known at the end)
+			ind.evalStats["prescreenInertConfirmed"] =
+			    over && ind.evalStats["prescreenInert"] && maxC == 1;
+		ind.evalStats["simulatedTime"] += sc.simTime - t0;
+		ind.evalState.clear();
+		if (over) {
+			sc.terminate();
+		} else if (!options.replay) {
+			std::ostringstream snapshot;
+			sc.save(snapshot);
+			ind.evalState = snapshot.str();
+		}
 		std::ostringstream info;
 		typename Scenario::CellType stemCopy(ind.dna);
 		info << "  Net energy: " << sc.plantEnergy << ", max cells: " << maxC
 		     << ", grn size: [" << stemCopy.ctrl.grn.getProteinSize(ProteinType::input) << ","
 		     << stemCopy.ctrl.grn.getProteinSize(ProteinType::regul) << ","
-		     << stemCopy.ctrl.grn.getProteinSize(ProteinType::output) << "]" << endl;
+		     << stemCopy.ctrl.grn.getProteinSize(ProteinType::output) << "]";
+		if (!over) info << " (stopped at " << sc.simTime << "s)";
+		info << endl;
 		ind.infos = info.str();
 		ind.fitnesses["Survival"] = sc.simTime;
+		return over;
 	}
 };
 
 template <class Scenario> struct SurvivalNoveltyOnlyEvaluator {
 	const std::string name = "SurvivalNoveltyOnly";
-	int argc;
-	char **argv;
+	ScenarioOptions options;
 
-	SurvivalNoveltyOnlyEvaluator(int c, char **v) : argc(c), argv(v) {}
+	SurvivalNoveltyOnlyEvaluator(int c, char **v) : options(ScenarioOptions::parse(c, v)) {}
 
 	template <typename Individu> void operator()(Individu &ind) {
-		Scenario sc;
-		sc.setStemCell(new typename Scenario::CellType(ind.dna));
-		sc.init(argc, argv);
-		size_t maxC = 1;
-		while (!sc.finished()) {
-			sc.loop();
-			if (sc.getWorld().cells.size() > maxC) maxC = sc.getWorld().cells.size();
-		}
+		auto &sc =
+		    Scenario::threadLocal(new typename Scenario::CellType(ind.dna), options);
+		MaxCellsMetric<typename Scenario::CellType> maxC;
+		sc.addObserver(&maxC);
+		while (!sc.finished()) sc.loop();
 		sc.terminate();
 		std::ostringstream info;
 		typename Scenario::CellType stemCopy(ind.dna);
-		info << "  Survival time : " << sc.simTime << ", max cells: " << maxC
+		info << "  Survival time : " << sc.simTime << ", max cells: " << maxC.value
 		     << ", grn size: [" << stemCopy.ctrl.grn.getProteinSize(ProteinType::input) << ","
 		     << stemCopy.ctrl.grn.getProteinSize(ProteinType::regul) << ","
 		     << stemCopy.ctrl.grn.getProteinSize(ProteinType::output) << "]" << endl;
@@ -305,32 +340,23 @@ template <class Scenario> struct SurvivalNoveltyOnlyEvaluator {
 
 template <class Scenario> struct SurvivalAndNoveltyEvaluator {
 	const std::string name = "SurvivalAndNovelty";
-	int argc;
-	char **argv;
+	ScenarioOptions options;
 
-	SurvivalAndNoveltyEvaluator(int c, char **v) : argc(c), argv(v) {}
+	SurvivalAndNoveltyEvaluator(int c, char **v) : options(ScenarioOptions::parse(c, v)) {}
 
 	template <typename Individu> void operator()(Individu &ind) {
-		Scenario sc;
-		sc.setStemCell(new typename Scenario::CellType(ind.dna));
-		sc.init(argc, argv);
-		size_t maxC = 1;
-		double minY = 0.0;
-		while (!sc.finished()) {
-			sc.loop();
-			if (sc.getWorld().cells.size() > maxC) maxC = sc.getWorld().cells.size();
-			if (sc.getWorld().cells.size() > 0) {
-				for (auto &c : sc.getWorld().cells) {
-					auto y = c->getPosition().y();
-					if (y < minY && y > -1500) minY = y;
-				}
-			}
-		}
+		auto &sc =
+		    Scenario::threadLocal(new typename Scenario::CellType(ind.dna), options);
+		MaxCellsMetric<typename Scenario::CellType> maxC;
+		MinDepthMetric<typename Scenario::CellType> minY;
+		sc.addObserver(&maxC);
+		sc.addObserver(&minY);
+		while (!sc.finished()) sc.loop();
 		sc.terminate();
 		std::ostringstream info;
 		typename Scenario::CellType stemCopy(ind.dna);
-		info << "  Survival time : " << sc.simTime << ", max cells: " << maxC
-		     << ", max depth: " << minY << ", grn size: ["
+		info << "  Survival time : " << sc.simTime << ", max cells: " << maxC.value
+		     << ", max depth: " << minY.value << ", grn size: ["
 		     << stemCopy.ctrl.grn.getProteinSize(ProteinType::input) << ","
 		     << stemCopy.ctrl.grn.getProteinSize(ProteinType::regul) << ","
 		     << stemCopy.ctrl.grn.getProteinSize(ProteinType::output) << "]" << endl;
@@ -338,8 +364,8 @@ template <class Scenario> struct SurvivalAndNoveltyEvaluator {
 		vector<vector<double>> fp;
 		fp.push_back(vector<double>());
 		fp[0].push_back(sc.simTime);
-		fp[0].push_back(maxC);
-		fp[0].push_back(minY / 40.0);
+		fp[0].push_back(maxC.value);
+		fp[0].push_back(minY.value / 40.0);
 		ind.footprint = fp;
 		ind.fitnesses["Survival"] = sc.simTime;
 	}
@@ -347,10 +373,9 @@ template <class Scenario> struct SurvivalAndNoveltyEvaluator {
 
 template <class Scenario> struct SurvivalAndCaptureEvaluator {
 	const std::string name = "SurvivalAndCapture";
-	int argc;
-	char **argv;
+	ScenarioOptions options;
 
-	SurvivalAndCaptureEvaluator(int c, char **v) : argc(c), argv(v) {}
+	SurvivalAndCaptureEvaluator(int c, char **v) : options(ScenarioOptions::parse(c, v)) {}
 
 	template <typename T>
 	static std::vector<double> captMatrixTofootprint(const T &capture) {
@@ -367,33 +392,25 @@ template <class Scenario> struct SurvivalAndCaptureEvaluator {
 		const int W = 15;
 		const int H = 15;
 		const double maxH = 500.0;
-		Scenario sc;
-		sc.setStemCell(new typename Scenario::CellType(ind.dna));
-		sc.init(argc, argv);
-		ind.footprint = std::vector<vector<double>>();
-		size_t maxC = 1;
+		auto &sc =
+		    Scenario::threadLocal(new typename Scenario::CellType(ind.dna), options);
+		std::vector<vector<double>> footprint;
+		MaxCellsMetric<typename Scenario::CellType> maxC;
 		std::vector<std::string> capturesStr;
-		while (!sc.finished()) {
-			sc.loop();
-			if (sc.getWorld().cells.size() > maxC) maxC = sc.getWorld().cells.size();
-			while (ind.footprint.size() < capturesTime.size() &&
-			       sc.simTime > capturesTime[ind.footprint.size()]) {
-				auto capture =
-				    ClusterTools::getMatrixCapture<W, H>(sc.getWorld().cells, false, maxH);
-				ind.footprint.push_back(captMatrixTofootprint(capture));
-				capturesStr.push_back(ClusterTools::captMatrixToString(capture));
-			}
-		}
-		while (ind.footprint.size() < capturesTime.size()) {
-			auto capture =
-			    ClusterTools::getMatrixCapture<W, H>(sc.getWorld().cells, false, maxH);
-			ind.footprint.push_back(captMatrixTofootprint(capture));
-			capturesStr.push_back(ClusterTools::captMatrixToString(capture));
-		}
+		auto capture = [&]() {
+			auto c = ClusterTools::getMatrixCapture<W, H>(sc.getWorld().cells, false, maxH);
+			footprint.push_back(captMatrixTofootprint(c));
+			capturesStr.push_back(ClusterTools::captMatrixToString(c));
+		};
+		sc.addObserver(&maxC);
+		for (auto t : capturesTime) sc.at(t, capture);
+		while (!sc.finished()) sc.loop();
+		while (footprint.size() < capturesTime.size()) capture();
+		ind.footprint = footprint;
 		sc.terminate();
 		std::ostringstream info;
 		typename Scenario::CellType stemCopy(ind.dna);
-		info << "  Survival time : " << sc.simTime << ", max cells: " << maxC
+		info << "  Survival time : " << sc.simTime << ", max cells: " << maxC.value
 		     << ", grn size: [" << stemCopy.ctrl.grn.getProteinSize(ProteinType::input) << ","
 		     << stemCopy.ctrl.grn.getProteinSize(ProteinType::regul) << ","
 		     << stemCopy.ctrl.grn.getProteinSize(ProteinType::output) << "]" << endl;
@@ -407,23 +424,19 @@ template <class Scenario> struct SurvivalAndCaptureEvaluator {
 
 template <class Scenario> struct SurvivalAndMultiNoveltyEvaluator {
 	const std::string name = "SurvivalAndMultiNovelty";
-	int argc;
-	char **argv;
+	ScenarioOptions options;
 
-	SurvivalAndMultiNoveltyEvaluator(int c, char **v) : argc(c), argv(v) {}
+	SurvivalAndMultiNoveltyEvaluator(int c, char **v) : options(ScenarioOptions::parse(c, v)) {}
 
 	template <typename Individu> void operator()(Individu &ind) {
 		const std::array<double, 5> capturesTime = {{10.0, 20.0, 40.0, 60.0, 100.0}};
-		Scenario sc;
-		sc.setStemCell(new typename Scenario::CellType(ind.dna));
-		sc.init(argc, argv);
-		ind.footprint = std::vector<vector<double>>();
-		size_t maxC = 1;
-		while (!sc.finished()) {
-			sc.loop();
-			if (sc.getWorld().cells.size() > maxC) maxC = sc.getWorld().cells.size();
-			while (ind.footprint.size() < capturesTime.size() &&
-			       sc.simTime > capturesTime[ind.footprint.size()]) {
+		auto &sc =
+		    Scenario::threadLocal(new typename Scenario::CellType(ind.dna), options);
+		std::vector<vector<double>> footprint;
+		MaxCellsMetric<typename Scenario::CellType> maxC;
+		sc.addObserver(&maxC);
+		for (auto t : capturesTime) {
+			sc.at(t, [&]() {
 				vector<double> capture;
 				capture.push_back(sc.getWorld().cells.size());
 
@@ -436,26 +449,28 @@ template <class Scenario> struct SurvivalAndMultiNoveltyEvaluator {
 					capture.push_back(minY / 40.0);
 				} else
 					capture.push_back(0.0);
-				ind.footprint.push_back(capture);
-			}
+				footprint.push_back(capture);
+			});
 		}
-		while (ind.footprint.size() < capturesTime.size()) {
+		while (!sc.finished()) sc.loop();
+		while (footprint.size() < capturesTime.size()) {
 			vector<double> capture;
 			capture.push_back(-10);
 			capture.push_back(0);
-			ind.footprint.push_back(capture);
+			footprint.push_back(capture);
 		}
+		ind.footprint = footprint;
 
 		sc.terminate();
 		std::ostringstream info;
 		typename Scenario::CellType stemCopy(ind.dna);
-		info << "  Survival time : " << sc.simTime << ", max cells: " << maxC
+		info << "  Survival time : " << sc.simTime << ", max cells: " << maxC.value
 		     << ", grn size: [" << stemCopy.ctrl.grn.getProteinSize(ProteinType::input) << ","
 		     << stemCopy.ctrl.grn.getProteinSize(ProteinType::regul) << ","
 		     << stemCopy.ctrl.grn.getProteinSize(ProteinType::output) << "]" << endl;
 		for (size_t i = 0; i < capturesTime.size(); ++i) {
-			info << capturesTime[i] << " : " << ind.footprint[i][0] << ", "
-			     << ind.footprint[i][1] << std::endl;
+			info << capturesTime[i] << " : " << footprint[i][0] << ", " << footprint[i][1]
+			     << std::endl;
 		}
 		ind.infos = info.str();
 		ind.fitnesses["Survival"] = sc.simTime;
@@ -0,0 +1,69 @@
+#ifndef NUTRIENTLAYOUT_HPP
+#define NUTRIENTLAYOUT_HPP
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+#include <mecacell/mecacell.h>
+#include "config.hpp"
+
+// Static part of the ground nutrient sources: positions, radii and initial contents.
+// It only depends on the seed, so it is generated once per seed and shared, read only,
+// by every scenario of the process. Scenarios only own the current content of each
+// source.
+// There is no spatial index: the reach of a source grows as it empties, so every
+// source can contribute anywhere below ground.
+struct NutrientLayout {
+	std::vector<MecaCell::Vec> pos;
+	std::vector<double> sqradius;
+	std::vector<double> initialContent;
+
+	size_t size() const { return pos.size(); }
+
+	explicit NutrientLayout(int seed) {
+		pos.reserve(Config::NB_NUTRIENTS_SOURCES);
+		sqradius.reserve(Config::NB_NUTRIENTS_SOURCES);
+		initialContent.reserve(Config::NB_NUTRIENTS_SOURCES);
+		if (Config::NB_NUTRIENTS_SOURCES == 0) return;
+		auto internalRand = std::mt19937(seed);
+		auto uniformDist = std::uniform_real_distribution<double>(-0.5, 0.5);
+		// first source is right on the stem cell
+		add(MecaCell::Vec(0, Config::STEMCELL_Y, 0), Config::NUTRIENT_QUANTITY);
+		const MecaCell::Vec boundingCubeCenter(
+		    0.0, -Config::FIRST_NUTRIENT_SOURCE_THRESHOLD - Config::NUTRIENTS_BOUNDING_DEPTH * 0.5,
+		    0.0);
+		for (auto i = 1u; i < Config::NB_NUTRIENTS_SOURCES; ++i) {
+			MecaCell::Vec rdmPos =
+			    boundingCubeCenter +
+			    MecaCell::Vec(uniformDist(internalRand) * Config::NUTRIENTS_BOUNDING_AREA,
+			                  uniformDist(internalRand) * Config::NUTRIENTS_BOUNDING_DEPTH,
+			                  uniformDist(internalRand) * Config::NUTRIENTS_BOUNDING_AREA);
+			double qtty = Config::NUTRIENT_QUANTITY *
+			              (1.0 + (std::pow(std::abs(rdmPos.y() +
+			                                        Config::FIRST_NUTRIENT_SOURCE_THRESHOLD),
+			                               Config::NUTRIENT_DEPTH_INCREASE_POW) *
+			                      Config::NUTRIENT_DEPTH_INCREASE_COEF));
+			add(rdmPos, qtty);
+		}
+	}
+
+	// layouts already generated, by seed
+	static std::shared_ptr<const NutrientLayout> get(int seed) {
+		static std::mutex cacheMutex;
+		static std::map<int, std::shared_ptr<const NutrientLayout>> cache;
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		auto& l = cache[seed];
+		if (!l) l = std::make_shared<const NutrientLayout>(seed);
+		return l;
+	}
+
+ private:
+	void add(const MecaCell::Vec& p, double content) {
+		pos.push_back(p);
+		sqradius.push_back(std::pow(Config::TYPICAL_NUTRIENTS_RADIUS, 2));
+		initialContent.push_back(content);
+	}
+};
+#endif
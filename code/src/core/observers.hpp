@@ -0,0 +1,37 @@
+#ifndef OBSERVERS_HPP
+#define OBSERVERS_HPP
+#include <cstddef>
+
+// Hooks called by a scenario during its steps (see Scenario::addObserver), so that
+// evaluators can follow a simulation without scanning every cell after each step.
+// Events are reported once per step, after the world update, when positions are final:
+// a cell is born (divisions), dies (removed at the end of the step) or was awake and may
+// have moved. Sleeping cells do not move and are not reported.
+template <typename Cell> struct ScenarioObserver {
+	virtual ~ScenarioObserver() {}
+	virtual void onBirth(const Cell &) {}
+	virtual void onDeath(const Cell &) {}
+	virtual void onMove(const Cell &) {}
+	virtual void onStep(double /*simTime*/, size_t /*nbCells*/) {}  // end of each step
+};
+
+// largest number of cells seen at the end of a step
+template <typename Cell> struct MaxCellsMetric : public ScenarioObserver<Cell> {
+	size_t value = 1;
+	void onStep(double, size_t nbCells) override {
+		if (nbCells > value) value = nbCells;
+	}
+};
+
+// lowest height reached by a living cell, cells that fell below floor aside
+template <typename Cell> struct MinDepthMetric : public ScenarioObserver<Cell> {
+	double value = 0.0;
+	double floor = -1500.0;
+	void onBirth(const Cell &c) override { see(c); }
+	void onMove(const Cell &c) override { see(c); }
+	void see(const Cell &c) {
+		const double y = c.getPosition().y();
+		if (y < value && y > floor) value = y;
+	}
+};
+#endif
@@ -0,0 +1,75 @@
+#ifndef PHASEEXECUTOR_HPP
+#define PHASEEXECUTOR_HPP
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include "config.hpp"
+#ifdef OMP
+#include <omp.h>
+#endif
+
+// Runs the per-cell phases of a scenario step (sensing, inputs, GRN, forces...)
+// on several threads.
+// Cells are always split into chunks of Config::CELL_PHASE_CHUNK, whatever the number
+// of threads, and reductions are first done inside each chunk then combined in chunk
+// order. Results are thus the same with 1 or 24 threads.
+// When called from inside an already active parallel region (typically the GA
+// evaluation loop), phases run serially on the calling thread: the cores are already
+// busy and nesting would only oversubscribe them.
+struct PhaseExecutor {
+	static bool parallelAllowed(size_t n) {
+#ifdef OMP
+		return n >= Config::MIN_CELLS_FOR_PARALLEL_PHASE && omp_get_active_level() == 0 &&
+		       omp_get_max_threads() > 1;
+#else
+		(void)n;
+		return false;
+#endif
+	}
+
+	// f(i) is called once for each i in [0, n[. Iterations must be independent.
+	template <typename F> static void forIndex(size_t n, F &&f) {
+		const long l = static_cast<long>(n);
+		if (!parallelAllowed(n)) {
+			for (long i = 0; i < l; ++i) f(static_cast<size_t>(i));
+			return;
+		}
+#ifdef OMP
+		const int chunk = static_cast<int>(Config::CELL_PHASE_CHUNK);
+#pragma omp parallel for schedule(static, chunk)
+		for (long i = 0; i < l; ++i) f(static_cast<size_t>(i));
+#endif
+	}
+
+	// f(elem) is called once per element. Elements must be independent.
+	template <typename T, typename F> static void forEach(const std::vector<T> &v, F &&f) {
+		forIndex(v.size(), [&](size_t i) { f(v[i]); });
+	}
+
+	// returns op(...op(op(identity, chunk0), chunk1)..., chunkN) where each chunk is
+	// op(...op(identity, f(e0)), f(e1)...) over its elements.
+	template <typename R, typename T, typename F, typename Op>
+	static R reduce(const std::vector<T> &v, const R &identity, F &&f, Op &&op) {
+		const size_t chunk = Config::CELL_PHASE_CHUNK;
+		const long nChunks = static_cast<long>((v.size() + chunk - 1) / chunk);
+		std::vector<R> partials(nChunks, identity);
+		auto reduceChunk = [&](long c) {
+			const size_t end = std::min(v.size(), (c + 1) * chunk);
+			R acc = identity;
+			for (size_t i = c * chunk; i < end; ++i) acc = op(acc, f(v[i]));
+			partials[c] = acc;
+		};
+		if (parallelAllowed(v.size())) {
+#ifdef OMP
+#pragma omp parallel for schedule(static, 1)
+			for (long c = 0; c < nChunks; ++c) reduceChunk(c);
+#endif
+		} else {
+			for (long c = 0; c < nChunks; ++c) reduceChunk(c);
+		}
+		R res = identity;
+		for (const auto &p : partials) res = op(res, p);
+		return res;
+	}
+};
+#endif
@@ -1,11 +1,18 @@
 #ifndef PLANTCELL_HPP
 #define PLANTCELL_HPP
 #include "config.hpp"
+#include "blockpool.hpp"
+#include "cellrandom.hpp"
+#include "cellstatetable.hpp"
 #include "../external/grgen/common.h"
 #include <mecacell/mecacell.h>
+#include <cmath>
 #include <random>
+#include <sstream>
+#include <string>
+#include <algorithm>
+#include <vector>
 
-enum class CycleStep { quiescent, growing };
 template <typename Controller, template <class> class Membrane = MecaCell::VolumeMembrane>
 class PlantCell
     : public MecaCell::ConnectableCell<PlantCell<Controller, Membrane>, Membrane> {
@@ -15,56 +22,108 @@ class PlantCell
 	using CtrlType = Controller;
 	using morphogrid =
 	    std::vector<std::array<std::pair<MecaCell::Vec, double>, Config::NB_MORPHOGENS>>;
+	using StateTable = CellStateTable<PlantCell>;
 
 	std::normal_distribution<double> growthDistribution;
-	std::mt19937 internalRand;
-	std::array<double, Config::NB_MORPHOGENS> morphogensProduction{};
-	std::array<double, Config::NB_MORPHOGENS> sensedMorphogens{};
-	double age = 0.0;
-	std::array<double, Config::NB_NUTRIENTS> sensedNutrients{};
-	// sensed in the environment
-	std::array<double, Config::NB_NUTRIENTS> nutrientLevel{};  // actual amount
+	CellRandom internalRand;
+	// nutrients, morphogens, age and cycle step are stored in a CellStateTable
+	StateTable* stateTable;
+	size_t slot;
 	int needToComputeGradient = -1;
 	double morphoUpdateDt = 0.0;
-	CycleStep currentStep = CycleStep::quiescent;
 	Controller ctrl;
 	MecaCell::Vec divisionDirection{0, 0, 0};
-	unordered_set<PlantCell*> trulyConnectedCells{};
+	std::vector<PlantCell*> trulyConnectedCells{};  // cleared, not reallocated
+	bool controllerUpdated = false;  // set when the GRN step already ran for this update
+	size_t graphIndex = 0;           // index in the world's cells, see ConnectionGraph
+	bool justBorn = false;           // divided off a cell, until the scenario settles it
+	// sleep (see updateSleep)
+	bool sleeping = false;
+	unsigned int stepsAtRest = 0;
+	size_t sleepNeighbours = 0;  // neighbours signature when falling asleep
+	std::array<double, 2 * Config::NB_NUTRIENTS + Config::NB_MORPHOGENS> sleepInputs{};
+	std::array<double, Config::NB_MORPHOGENS> lastMorphogensProduction{};
 
-	PlantCell(const Vec& p) : Base(p), ctrl(Controller::random(0, 0)) {
+	PlantCell(const Vec& p)
+	    : Base(p),
+	      stateTable(&StateTable::detached()),
+	      slot(stateTable->add(this)),
+	      ctrl(Controller::random(0, 0)) {
 		init();
-		nutrientLevel.fill(0.2);
+		for (size_t i = 0; i < Config::NB_NUTRIENTS; ++i) nutrientLevel(i) = 0.2;
 	}
 
+	// the copy goes in the same state table as c (a daughter of c, see justBorn)
 	PlantCell(const PlantCell& c, const Vec& p = Vec(0, 0, 0))
 	    : Base(c, p),
-	      morphogensProduction(c.morphogensProduction),
-	      sensedMorphogens(c.sensedMorphogens),
-	      age(0.0),
-	      ctrl(c.ctrl) {
+	      stateTable(c.stateTable),
+	      slot(stateTable->add(this)),
+	      ctrl(c.ctrl),
+	      justBorn(true) {
+		for (size_t i = 0; i < Config::NB_MORPHOGENS; ++i) {
+			morphogenProduction(i) = c.morphogenProduction(i);
+			sensedMorphogen(i) = c.sensedMorphogen(i);
+		}
 		init();
-		for (size_t i = 0; i < nutrientLevel.size(); ++i) {
-			nutrientLevel[i] = c.nutrientLevel[i];
-			sensedNutrients[i] = c.sensedNutrients[i];
+		for (size_t i = 0; i < Config::NB_NUTRIENTS; ++i) {
+			nutrientLevel(i) = c.nutrientLevel(i);
+			sensedNutrient(i) = c.sensedNutrient(i);
 		}
 	}
 
-	PlantCell(const Controller& ct, const Vec& p = Vec(0, 0, 0)) : Base(p), ctrl(ct) {
+	PlantCell(const Controller& ct, const Vec& p = Vec(0, 0, 0))
+	    : Base(p), stateTable(&StateTable::detached()), slot(stateTable->add(this)), ctrl(ct) {
 		init();
-		nutrientLevel.fill(0.2);
+		for (size_t i = 0; i < Config::NB_NUTRIENTS; ++i) nutrientLevel(i) = 0.2;
+	}
+
+	~PlantCell() { stateTable->remove(slot); }
+	PlantCell& operator=(const PlantCell&) = delete;
+
+	double& nutrientLevel(size_t n) { return stateTable->nutrientLevel[n][slot]; }
+	double nutrientLevel(size_t n) const { return stateTable->nutrientLevel[n][slot]; }
+	// sensed in the environment
+	double& sensedNutrient(size_t n) { return stateTable->sensedNutrients[n][slot]; }
+	double sensedNutrient(size_t n) const { return stateTable->sensedNutrients[n][slot]; }
+	double& morphogenProduction(size_t i) { return stateTable->morphogensProduction[i][slot]; }
+	double morphogenProduction(size_t i) const {
+		return stateTable->morphogensProduction[i][slot];
+	}
+	double& sensedMorphogen(size_t i) { return stateTable->sensedMorphogens[i][slot]; }
+	double sensedMorphogen(size_t i) const { return stateTable->sensedMorphogens[i][slot]; }
+	double& age() { return stateTable->age[slot]; }
+	double age() const { return stateTable->age[slot]; }
+	CycleStep& currentStep() { return stateTable->currentStep[slot]; }
+	CycleStep currentStep() const { return stateTable->currentStep[slot]; }
+
+#ifndef NO_BLOCK_POOL
+	// cells are recycled through a per thread pool (see BlockPool)
+	static void* operator new(size_t sz) {
+		return sz == sizeof(PlantCell) ? BlockPool<sizeof(PlantCell)>::allocate() :
+		                                 ::operator new(sz);
+	}
+	static void operator delete(void* ptr, size_t sz) {
+		if (sz == sizeof(PlantCell))
+			BlockPool<sizeof(PlantCell)>::deallocate(ptr);
+		else
+			::operator delete(ptr);
 	}
+#endif
 
 	void init() {
-		age = 0.0;
-		sensedNutrients.fill(0.0);
+		age() = 0.0;
+		for (size_t i = 0; i < Config::NB_NUTRIENTS; ++i) sensedNutrient(i) = 0.0;
 		needToComputeGradient = -1;
 		morphoUpdateDt = 0.0;
-		currentStep = CycleStep::quiescent;
+		controllerUpdated = false;
+		sleeping = false;
+		stepsAtRest = 0;
+		currentStep() = CycleStep::quiescent;
 		divisionDirection = MecaCell::Vec(0, 0, 0);
 
 		internalRand =
-		    std::mt19937(static_cast<int>(this->getPosition().x() * this->getPosition().y() +
-		                                  this->getPosition().z() + nutrientLevel[0] * 10.0));
+		    CellRandom(static_cast<int>(this->getPosition().x() * this->getPosition().y() +
+		                                this->getPosition().z() + nutrientLevel(0) * 10.0));
 		growthDistribution = std::normal_distribution<double>(
 		    Config::CELL_GROWTH_SPEED * Config::SIM_DT,
 		    Config::CELL_GROWTH_SPEED * Config::SIM_DT * 0.5);
@@ -74,13 +133,14 @@ class PlantCell
 		auto on = ctrl.getOutput("on");
 		for (auto i = 0u; i < Config::NB_MORPHOGENS; ++i) {
 			auto o = ctrl.getOutput(std::string("o") + std::to_string(i));
-			morphogensProduction[i] = (on > 0.0 && o > 0.0) ? o / (o + on) : 0.0;
+			morphogenProduction(i) = (on > 0.0 && o > 0.0) ? o / (o + on) : 0.0;
 		}
 	}
 
 	double getAdhesionWith(PlantCell* c, MecaCell::Vec) const {
 		if (Config::ENABLE_SOLIDIFY) {
-			return (trulyConnectedCells.count(c) ||
+			return (std::find(trulyConnectedCells.begin(), trulyConnectedCells.end(), c) !=
+			            trulyConnectedCells.end() ||
 			        ctrl.getOutput("s") < ctrl.getOutput("st")) ?
 			           1.0 :
 			           0.0;
@@ -98,23 +158,23 @@ class PlantCell
 		return sm;
 	}
 
-	void setSensedNutrients(size_t n, double cn) { sensedNutrients[n] = cn; }
+	void setSensedNutrients(size_t n, double cn) { sensedNutrient(n) = cn; }
 
-	void deltaNutrient(size_t n, double amount) { nutrientLevel[n] += amount; }
+	void deltaNutrient(size_t n, double amount) { nutrientLevel(n) += amount; }
 
 	template <typename Sc> void updateInputs(const morphogrid& mg, const Sc* scenar) {
 		if (morphoUpdateDt >= Config::MORPHOGEN_UPDATE_INTERVAL) morphoUpdateDt = 0.0;
 		if (morphoUpdateDt == 0.0) {
 			for (auto i = 0u; i < Config::NB_MORPHOGENS; ++i) {
-				sensedMorphogens[i] = computeMorphogenIntensity(i, this->getPosition(), mg);
-				ctrl.setInput(std::string("c") + std::to_string(i), sensedMorphogens[i]);
+				sensedMorphogen(i) = computeMorphogenIntensity(i, this->getPosition(), mg);
+				ctrl.setInput(std::string("c") + std::to_string(i), sensedMorphogen(i));
 			}
 		}
 		for (auto i = 0u; i < Config::NB_NUTRIENTS; ++i) {
-			ctrl.setInput(std::string("n") + std::to_string(i), nutrientLevel[i]);
-			ctrl.setInput(std::string("cn") + std::to_string(i), sensedNutrients[i]);
+			ctrl.setInput(std::string("n") + std::to_string(i), nutrientLevel(i));
+			ctrl.setInput(std::string("cn") + std::to_string(i), sensedNutrient(i));
 		}
-		auto normalizedAge = (0.05 * age) / (0.05 * age + 1.0);
+		auto normalizedAge = (0.05 * age()) / (0.05 * age() + 1.0);
 		ctrl.setInput("t", normalizedAge);
 		ctrl.setInput("bias", 1.0);
 		ctrl.setInput("p", this->getNormalizedPressure());
@@ -149,36 +209,239 @@ class PlantCell
 	}
 
 	void updateTrulyConnectedCells() {
-		trulyConnectedCells = std::unordered_set<PlantCell*>();
+		trulyConnectedCells.clear();
 		for (auto& con : this->membrane.getCellCellConnectionManager().cellConnections) {
 			if (con->adhCoef > 0.1) {
 				if (this == con->cells.first)
-					trulyConnectedCells.insert(con->cells.second);
+					trulyConnectedCells.push_back(con->cells.second);
 				else
-					trulyConnectedCells.insert(con->cells.first);
+					trulyConnectedCells.push_back(con->cells.first);
 			}
 		}
 	}
 
+	// Sleeping cells are neither moved nor have their GRN updated; they only keep on
+	// consuming nutrients. A quiescent, solidified cell falls asleep after
+	// Config::SLEEP_DELAY steps at rest (low speed and force, stable morphogen production)
+	// and wakes up as soon as its connections (new contact, neighbour division or death),
+	// the force it receives or its inputs change.
+	// Must be called after forces are computed and before positions are integrated.
+	void updateSleep(double dt) {
+		const bool calm =
+		    this->getForce().length() < Config::SLEEP_MAX_FORCE &&
+		    (this->getPosition() - this->getPrevposition()).length() <
+		        Config::SLEEP_MAX_SPEED * dt;
+		if (sleeping) {
+			if (!calm || computeNeighboursSignature() != sleepNeighbours ||
+			    inputsChangedSinceSleep())
+				wakeUp();
+			return;
+		}
+		bool stable = calm && currentStep() == CycleStep::quiescent &&
+		              needToComputeGradient < 0 && ctrl.getOutput("s") < ctrl.getOutput("st");
+		for (size_t i = 0; i < Config::NB_MORPHOGENS; ++i) {
+			stable = stable && std::abs(morphogenProduction(i) - lastMorphogensProduction[i]) <
+			                       Config::SLEEP_INPUT_TOLERANCE;
+			lastMorphogensProduction[i] = morphogenProduction(i);
+		}
+		stepsAtRest = stable ? stepsAtRest + 1 : 0;
+		if (stepsAtRest >= Config::SLEEP_DELAY) {
+			sleeping = true;
+			sleepNeighbours = computeNeighboursSignature();
+			sleepInputs = currentInputs();
+		}
+	}
+
+	void wakeUp() {
+		sleeping = false;
+		stepsAtRest = 0;
+	}
+
+	size_t computeNeighboursSignature() const {
+		const auto& connections = this->membrane.getCellCellConnectionManager().cellConnections;
+		size_t res = connections.size();
+		for (const auto& con : connections)
+			res ^= std::hash<const void*>()(this == con->cells.first ? con->cells.second :
+			                                                           con->cells.first);
+		return res;
+	}
+
+	std::array<double, 2 * Config::NB_NUTRIENTS + Config::NB_MORPHOGENS> currentInputs() const {
+		std::array<double, 2 * Config::NB_NUTRIENTS + Config::NB_MORPHOGENS> res;
+		for (size_t i = 0; i < Config::NB_NUTRIENTS; ++i) {
+			res[2 * i] = nutrientLevel(i);
+			res[2 * i + 1] = sensedNutrient(i);
+		}
+		for (size_t i = 0; i < Config::NB_MORPHOGENS; ++i)
+			res[2 * Config::NB_NUTRIENTS + i] = sensedMorphogen(i);
+		return res;
+	}
+
+	bool inputsChangedSinceSleep() const {
+		const auto in = currentInputs();
+		for (size_t i = 0; i < in.size(); ++i)
+			if (std::abs(in[i] - sleepInputs[i]) > Config::SLEEP_INPUT_TOLERANCE) return true;
+		return false;
+	}
+
+	// Everything a snapshot needs to rebuild this cell (see Scenario::save). Connections
+	// are the scenario's business: only the cells this one adheres to are saved here, by
+	// slot.
+	template <typename W> void saveState(W& out) const {
+		out(this->getPosition());
+		out(this->getPrevposition());
+		out(this->getVelocity());
+		out(this->getOrientationRotation());
+		out(this->getAngularVelocity());
+		out(static_cast<double>(this->getMass()));
+		out(static_cast<double>(this->getRelativeVolume()));
+		for (size_t i = 0; i < Config::NB_NUTRIENTS; ++i) {
+			out(nutrientLevel(i));
+			out(sensedNutrient(i));
+		}
+		for (size_t i = 0; i < Config::NB_MORPHOGENS; ++i) {
+			out(morphogenProduction(i));
+			out(sensedMorphogen(i));
+		}
+		out(age());
+		out(currentStep());
+		out(needToComputeGradient);
+		out(morphoUpdateDt);
+		out(divisionDirection);
+		out(controllerUpdated);
+		out(sleeping);
+		out(stepsAtRest);
+		out(sleepInputs);
+		out(lastMorphogensProduction);
+		out(internalRand.getState());
+		std::ostringstream gd;
+		gd << growthDistribution;
+		out(gd.str());
+		std::vector<uint64_t> connected;  // (sorted: the order is irrelevant)
+		for (const auto* c : trulyConnectedCells) connected.push_back(c->slot);
+		std::sort(connected.begin(), connected.end());
+		out(connected);
+		out(ctrl.getConcentrations());
+	}
+
+	// cells: the restored cells, by slot
+	template <typename R> void loadState(R& in, const std::vector<PlantCell*>& cells) {
+		Vec v;
+		in(v);
+		this->setPosition(v);
+		in(v);
+		this->setPrevposition(v);
+		in(v);
+		this->setVelocity(v);
+		in(v);
+		this->setOrientationRotation(v);
+		this->updateCurrentOrientation();
+		in(v);
+		this->setAngularVelocity(v);
+		double d = 0.0;
+		in(d);
+		this->setMass(d);
+		in(d);
+		// MecaCell has no volume setter: this assumes grow adds to the volume, and the
+		// snapshot is rejected if it did not
+		this->grow(d - this->getRelativeVolume());
+		if (std::abs(this->getRelativeVolume() - d) > 1e-9 * std::max(1.0, std::abs(d)))
+			in.fail();
+		for (size_t i = 0; i < Config::NB_NUTRIENTS; ++i) {
+			in(nutrientLevel(i));
+			in(sensedNutrient(i));
+		}
+		for (size_t i = 0; i < Config::NB_MORPHOGENS; ++i) {
+			in(morphogenProduction(i));
+			in(sensedMorphogen(i));
+		}
+		in(age());
+		in(currentStep());
+		in(needToComputeGradient);
+		in(morphoUpdateDt);
+		in(divisionDirection);
+		in(controllerUpdated);
+		in(sleeping);
+		in(stepsAtRest);
+		in(sleepInputs);
+		in(lastMorphogensProduction);
+		std::array<uint64_t, 2> rnd{};
+		in(rnd);
+		internalRand.setState(rnd);
+		std::string gd;
+		in(gd);
+		std::istringstream(gd) >> growthDistribution;
+		std::vector<uint64_t> connected;
+		in(connected);
+		trulyConnectedCells.clear();
+		for (auto s : connected)
+			if (s < cells.size()) trulyConnectedCells.push_back(cells[s]);
+		std::vector<double> conc;
+		in(conc);
+		ctrl.setConcentrations(conc);
+	}
+
+	// Least a division can still cost this cell, in each nutrient: it first has to grow to
+	// twice its volume, consuming Config::DIVISION_NRJ_CONSUMPTION, and grows at most 2.5
+	// times the mean growth per step (3 standard deviations above it).
+	double minDivisionCost() const {
+		const double v = this->getRelativeVolume();
+		if (v >= 2.0) return 0.0;
+		const double maxGrowth = 2.5 * Config::CELL_GROWTH_SPEED * Config::SIM_DT;
+		return std::ceil((2.0 - v) / maxGrowth) * Config::DIVISION_NRJ_CONSUMPTION *
+		       Config::SIM_DT;
+	}
+
+	bool isStarving() const {
+		for (auto i = 0u; i < Config::NB_NUTRIENTS; ++i)
+			if (nutrientLevel(i) < 0) return true;
+		return false;
+	}
+
+	// Everything in updateBehavior that only touches this cell: can be run beforehand,
+	// on all cells in parallel (see Scenario::updateControllers).
+	// nbUpdates = 0 keeps the current GRN outputs (see MultiRateScheduler)
+	void updateController(unsigned int nbUpdates = 1) {
+		if (isStarving()) return;
+		if (sleeping) {  // outputs stay as they were
+			controllerUpdated = true;
+			return;
+		}
+		updateTrulyConnectedCells();
+		if (nbUpdates > 0) {
+			ctrl.update(nbUpdates);
+			updateMorphogensProduction();
+		}
+		controllerUpdated = true;
+	}
+
 	PlantCell* updateBehavior(double dt) {
-		for (auto i = 0u; i < nutrientLevel.size(); ++i) {
-			if (nutrientLevel[i] < 0) {
-				this->die();
-				return nullptr;
-			}
+		if (isStarving()) {
+			this->die();
+			return nullptr;
 		}
-		age += dt;
+		age() += dt;
 		morphoUpdateDt += dt;
-		updateTrulyConnectedCells();
-		ctrl.update();
-		updateMorphogensProduction();
-		this->setColorHSV(360.0 + 50.0 - nutrientLevel[WATER] * 200.0, 0.85,
-		                  0.7 + 0.2 * sensedNutrients[LIGHT]);
+		if (sleeping) {
+			// frozen outputs: the cell would just make the same quiescent decision again
+			controllerUpdated = false;
+			for (size_t i = 0; i < Config::NB_NUTRIENTS; ++i)
+				nutrientLevel(i) -= Config::NORMAL_NRJ_CONSUMPTION * dt;
+			return nullptr;
+		}
+		if (!controllerUpdated) {
+			updateTrulyConnectedCells();
+			ctrl.update();
+			updateMorphogensProduction();
+		}
+		controllerUpdated = false;
+		this->setColorHSV(360.0 + 50.0 - nutrientLevel(WATER) * 200.0, 0.85,
+		                  0.7 + 0.2 * sensedNutrient(LIGHT));
 		// this->color = {{sensedMorphogens[0] * 0.2, sensedMorphogens[1] * 0.2,
 		// sensedMorphogens[2] * 0.2}};
 		// this->color = {
 		//{sensedNutrients[0], sensedNutrients[1], nutrientLevel[0] + nutrientLevel[1]}};
-		if (currentStep == CycleStep::growing) {
+		if (currentStep() == CycleStep::growing) {
 			if (this->getRelativeVolume() >= 2.0) {
 				if (divisionDirection.sqlength() == 0.0) {
 					// no morpho gradient, random direction
@@ -189,9 +452,9 @@ class PlantCell
 				}
 				this->setMass(this->getBaseMass());
 				this->membrane.division();
-				this->currentStep = CycleStep::quiescent;
-				for (auto& n : nutrientLevel) {
-					n *= 0.5;  // dividing nutrients by 2
+				currentStep() = CycleStep::quiescent;
+				for (size_t i = 0; i < Config::NB_NUTRIENTS; ++i) {
+					nutrientLevel(i) *= 0.5;  // dividing nutrients by 2
 				}
 				auto decalage =
 				    divisionDirection * this->getMembraneDistance(divisionDirection) * 1.1;
@@ -201,42 +464,56 @@ class PlantCell
 			} else {
 				this->grow(std::max(growthDistribution(internalRand),
 				                    0.0));  // add a bit of randomness for asynchronicity
-				for (auto& n : nutrientLevel) n -= Config::DIVISION_NRJ_CONSUMPTION * dt;
+				for (size_t i = 0; i < Config::NB_NUTRIENTS; ++i)
+					nutrientLevel(i) -= Config::DIVISION_NRJ_CONSUMPTION * dt;
 			}
 		} else {
-			currentStep = CycleStep::quiescent;
+			currentStep() = CycleStep::quiescent;
 			size_t idStrongestDivGradient = 0;
-			double maxDivOut = ctrl.getOutput("d0");
-			for (auto i = 1u; i <= Config::NB_MORPHOGENS; ++i) {
-				double concentration = 0.0;
-				if (i == Config::NB_MORPHOGENS)
-					concentration = ctrl.getOutput(std::string("dn"));
-				else
-					concentration = ctrl.getOutput(std::string("d") + std::to_string(i));
-				if (concentration > maxDivOut) {
-					maxDivOut = concentration;
-					idStrongestDivGradient = i;
-				}
-			}
-			double apop = ctrl.getOutput("a");
-			double quiesc = ctrl.getOutput("q");
-			if (maxDivOut > quiesc && maxDivOut > apop) {
-				currentStep = CycleStep::growing;
+			const Fate f = quiescentFate(ctrl, idStrongestDivGradient);
+			if (f == Fate::divide) {
+				currentStep() = CycleStep::growing;
 				needToComputeGradient = idStrongestDivGradient;
-			} else if (apop > quiesc) {
+			} else if (f == Fate::die) {
 				this->die();
 			}
-			for (auto& n : nutrientLevel) n -= Config::NORMAL_NRJ_CONSUMPTION * dt;
+			for (size_t i = 0; i < Config::NB_NUTRIENTS; ++i)
+				nutrientLevel(i) -= Config::NORMAL_NRJ_CONSUMPTION * dt;
 		}
 		return nullptr;
 	}
 
+	enum class Fate { quiescent, divide, die };
+
+	// Decision of a quiescent cell with these controller outputs. When dividing,
+	// gradient is the morphogen to follow (Config::NB_MORPHOGENS for nutrients).
+	static Fate quiescentFate(const Controller& ct, size_t& gradient) {
+		gradient = 0;
+		double maxDivOut = ct.getOutput("d0");
+		for (auto i = 1u; i <= Config::NB_MORPHOGENS; ++i) {
+			double concentration = 0.0;
+			if (i == Config::NB_MORPHOGENS)
+				concentration = ct.getOutput(std::string("dn"));
+			else
+				concentration = ct.getOutput(std::string("d") + std::to_string(i));
+			if (concentration > maxDivOut) {
+				maxDivOut = concentration;
+				gradient = i;
+			}
+		}
+		double apop = ct.getOutput("a");
+		double quiesc = ct.getOutput("q");
+		if (maxDivOut > quiesc && maxDivOut > apop) return Fate::divide;
+		if (apop > quiesc) return Fate::die;
+		return Fate::quiescent;
+	}
+
 	template <typename Sc> MecaCell::Vec computeNutrientGradient(const Sc* scenar) {
 		using V = MecaCell::Vec;
 		const auto d = Config::NUTRIENT_SAMPLING_DIST;
 		const auto p = this->getPosition();
 		MecaCell::Vec res(0, 0, 0);
-		for (auto& n : scenar->nutrientSources) {
+		for (auto n : scenar->reachableSources) {  // the others contribute 0
 			res += MecaCell::Vec(scenar->computeNutrientIntensity(p + V(d, 0, 0), n, true) -
 			                         scenar->computeNutrientIntensity(p - V(d, 0, 0), n, true),
 			                     scenar->computeNutrientIntensity(p + V(0, d, 0), n, true) -
@@ -244,7 +521,7 @@ class PlantCell
 			                     scenar->computeNutrientIntensity(p + V(0, 0, d), n, true) -
 			                         scenar->computeNutrientIntensity(p - V(0, 0, d), n, true));
 		}
-		res /= static_cast<double>(scenar->nutrientSources.size());
+		res /= static_cast<double>(scenar->nutrientContent.size());
 		if (res.sqlength() > 0)
 			return -res.normalized();
 		else
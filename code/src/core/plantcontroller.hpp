@@ -1,7 +1,9 @@
 #ifndef PLANTCONTROLLER_HPP
 #define PLANTCONTROLLER_HPP
+#include <cstdint>
 #include <string>
 #include <sstream>
+#include <vector>
 #include "config.hpp"
 #include "../external/grgen/common.h"
 
@@ -22,7 +24,9 @@ template <typename GRN> struct GRNPlantController {
 		return *this;
 	}
 
-	void update() { grn.step(Config::GRN_STEPS_PER_UPDATE); }
+	void update(unsigned int nbUpdates = 1) {
+		grn.step(Config::GRN_STEPS_PER_UPDATE * nbUpdates);
+	}
 	// GA specific methods
 	GRNPlantController crossover(const GRNPlantController &other) {
 		GRN g = grn.crossover(other.grn);
@@ -39,6 +43,25 @@ template <typename GRN> struct GRNPlantController {
 		return r;
 	}
 	std::string toJSON() const { return grn.toJSON(); }
+	uint64_t canonicalHash() const { return grn.canonicalHash(); }  // (see GAGA::GA cache)
+
+	// current and previous concentration of every protein (the only state of the GRN
+	// which changes during a simulation)
+	std::vector<double> getConcentrations() const {
+		std::vector<double> res;
+		for (const auto &p : grn.getActualProteinsCopy()) {
+			res.push_back(p.c);
+			res.push_back(p.prevc);
+		}
+		return res;
+	}
+	void setConcentrations(const std::vector<double> &conc) {
+		auto &proteins = grn.getActualProteins();
+		for (size_t i = 0; i < proteins.size() && 2 * i + 1 < conc.size(); ++i) {
+			proteins[i].c = conc[2 * i];
+			proteins[i].prevc = conc[2 * i + 1];
+		}
+	}
 
 	static GRNPlantController random(int, char **) {
 		// inputs
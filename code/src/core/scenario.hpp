@@ -4,13 +4,30 @@
 #include "../external/cxxopts.hpp"
 #include "typesconfig.hpp"
 #include "config.hpp"
+#include "phaseexecutor.hpp"
+#include "connectiongraph.hpp"
+#include "scheduler.hpp"
+#include "scenariooptions.hpp"
+#include "nutrientlayout.hpp"
+#include "snapshot.hpp"
+#include "observers.hpp"
 #include <mecacell/mecacell.h>
 #include <mecacell/grid.hpp>
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cmath>
+#include <functional>
+#include <map>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 template <typename Cell> class Scenario {
+	static constexpr uint64_t SNAPSHOT_MAGIC = 0x50414e5341455353ULL;  // "SSEASNAP"
+	static constexpr uint64_t SNAPSHOT_VERSION = 2;
+
 	struct PosIntegrator {
 		static void updatePosition(Cell& c, const float_t& dt) {
 			// c.setVelocity(c.getVelocity() + c.getForce() * dt / c.getMass());
@@ -29,116 +46,398 @@ template <typename Cell> class Scenario {
 		}
 	};
 
-	struct NutrientSource {
-		MecaCell::Vec pos;
-		double sqradius;
-		double content;
-		double initialcontent = Config::NUTRIENT_QUANTITY;
-	};
-
  public:
 	using World = MecaCell::BasicWorld<Cell>;
 	using CellType = Cell;
 	using CtrlType = typename Cell::CtrlType;
+	using ConnectionMap = decltype(std::declval<World&>().cellCellConnections);
+	using Connection = typename ConnectionMap::mapped_type::element_type;
 
  protected:
+	// declared before the world, whose cells release their rows when destroyed
+	typename Cell::StateTable states;
 	World w;
 	double simDuration = Config::DEFAULT_SIM_DURATION;
 	unsigned int maxCells = Config::DEFAULT_MAX_CELLS;
 	unique_ptr<Cell> stemCell;
 	std::chrono::time_point<std::chrono::system_clock> start;
-	int randomSeed = 1000;
 	MecaCell::Vec stemCellPosition{0, 30, 0};
 	MecaCell::Grid<Cell*> cellgrid =
 	    MecaCell::Grid<Cell*>(2.0 * MecaCell::DEFAULT_CELL_RADIUS);
+	ConnectionGraph connections;
+	std::vector<std::array<double, Config::NB_NUTRIENTS>> connectionFlux;
+	typename Cell::morphogrid morphogens;
+	unsigned long nbSteps = 0;
+	ScenarioOptions options;  // as given to init
+	std::vector<ScenarioObserver<Cell>*> observers;  // not owned
+	std::multimap<double, std::function<void()>> timers;
 
  public:
-	std::vector<NutrientSource> nutrientSources;
+	MultiRateScheduler scheduler;
+	std::shared_ptr<const NutrientLayout> nutrientLayout;
+	std::vector<double> nutrientContent;  // current content of each nutrient source
+	std::vector<size_t> reachableSources;  // sources which can reach a cell in this step
 	double simTime = 0.0;
 	double plantEnergy = 0.0;
+	struct PrescreenResult {  // see prescreen
+		bool screened = false;        // the stem cell was screened
+		bool diedAtOnce = false;      // apoptosis on its first update (exact)
+		bool predictedInert = false;  // never divides nor dies on constant inputs (guess)
+		double time = 0.0;            // seconds spent screening
+	} prescreenResult;
 	unsigned int getMaxUpdates() { return simDuration / w.getDt(); }
 	void setStemCell(Cell* c) { stemCell = unique_ptr<Cell>(c); }
 
-	void init(int argc, char** argv) {
-		start = std::chrono::system_clock::now();
-		try {
-			cxxopts::Options options(argv[0]);
-			options.add_options()("duration", "simulation duration",
-			                      cxxopts::value<double>(simDuration));
-			options.add_options()("maxcell", "max number of cells",
-			                      cxxopts::value<unsigned int>(maxCells));
-			options.add_options()("r,random", "random grn as stem cell");
-			options.add_options()("f,file", "stem cell dna from file",
-			                      cxxopts::value<std::string>());
-			options.parse(argc, argv);
-			if (options.count("random")) {
-				stemCell = unique_ptr<Cell>(new Cell(CtrlType::random(argc, argv)));
-			} else if (options.count("file")) {
-				std::ifstream fstr(options["file"].as<std::string>());
+	void init(int argc, char** argv) { init(ScenarioOptions::parse(argc, argv)); }
+
+	void init(const ScenarioOptions& opts) {
+		options = opts;
+		simDuration = opts.simDuration;
+		maxCells = opts.maxCells;
+		scheduler = opts.rates;
+		nutrientLayout = NutrientLayout::get(opts.nutrientSeed);
+		if (!stemCell) {  // not already set by an evaluator or for a reference run
+			if (opts.randomStem) {
+				stemCell = unique_ptr<Cell>(new Cell(CtrlType::random(0, nullptr)));
+			} else if (!opts.stemFile.empty()) {
+				std::ifstream fstr(opts.stemFile);
 				std::stringstream buffer;
 				buffer << fstr.rdbuf();
 				stemCell = unique_ptr<Cell>(new Cell(CtrlType(buffer.str())));
 			}
-		} catch (const cxxopts::OptionException& e) {
-			std::cout << "error parsing options: " << e.what() << std::endl;
-			exit(1);
-		} catch (const std::bad_cast& e) {
-			std::cout << "bad cast: " << e.what() << std::endl;
+		}
+		if (!stemCell) {
+			std::cerr << "No stem cell, aborting." << std::endl;
 			exit(1);
 		}
 		w.setDt(Config::SIM_DT);
-		if (stemCell) {
-			w.setViscosityCoef(0.0);  // we handle viscosity by ourselves
-			stemCell->setPosition(MecaCell::Vec(0, Config::STEMCELL_Y, 0));
-			stemCell->nutrientLevel[WATER] = Config::STEMCELL_NUT0;
-			stemCell->nutrientLevel[LIGHT] = Config::STEMCELL_NUT1;
-			w.addCell(new Cell(*stemCell));
-			initNutrientsSources();
+		w.setViscosityCoef(0.0);  // we handle viscosity by ourselves
+		reset();
+	}
+
+	// starts over from a new stem cell, keeping the options given to init
+	void reset(Cell* c) {
+		setStemCell(c);
+		reset();
+	}
+
+	// back to the initial state: world containers, grids and nutrient sources are
+	// emptied or refilled in place rather than reallocated. Observers and timers are
+	// dropped.
+	void reset() {
+		clearObservers();
+		clear();
+		stemCell->setPosition(MecaCell::Vec(0, Config::STEMCELL_Y, 0));
+		stemCell->nutrientLevel(WATER) = Config::STEMCELL_NUT0;
+		stemCell->nutrientLevel(LIGHT) = Config::STEMCELL_NUT1;
+		w.addCell(new Cell(*stemCell));
+		adoptNewCells();
+		resetNutrientsSources();
+	}
+
+ protected:
+	// after a failed read (previousStem = nullptr: nothing was changed yet)
+	bool restoreFailed(unique_ptr<Cell> previousStem) {
+		std::cerr << "Truncated or corrupted snapshot." << std::endl;
+		if (previousStem) {
+			stemCell = std::move(previousStem);
+			reset();
+		}
+		return false;
+	}
+
+ public:
+	// no cell, t = 0
+	void clear() {
+		start = std::chrono::system_clock::now();
+		for (auto& c : w.cells) c->die();
+		w.destroyDeadCells();
+		states.compact();
+		w.frame = 0;
+		simTime = 0.0;
+		plantEnergy = 0.0;
+		nbSteps = 0;
+		morphogens.clear();
+		prescreenResult = PrescreenResult();
+	}
+
+	// Binary snapshot of the simulation, between two steps: cells (see PlantCell::saveState),
+	// their connections, nutrient sources contents, morphogens and time. The stem cell dna
+	// is included but not the options, so that a snapshot can be restored under other
+	// settings (rates, sleep, duration...). MecaCell's connections are saved whole, byte
+	// per byte, with the cells they join and each cell's own list of them. MecaCell
+	// orders the two cells of a connection by address, so each cell's rank by address is
+	// saved too.
+	void save(std::ostream& os) const {
+		SnapshotWriter out(os);
+		out(static_cast<uint64_t>(SNAPSHOT_MAGIC));  // (copies: not odr-used)
+		out(static_cast<uint64_t>(SNAPSHOT_VERSION));
+		out(options.nutrientSeed);
+		out(stemCell->ctrl.toJSON());
+		out(simTime);
+		out(plantEnergy);
+		out(static_cast<uint64_t>(nbSteps));
+		out(static_cast<uint64_t>(w.frame));
+		out(nutrientContent);
+		out(static_cast<uint64_t>(morphogens.size()));
+		for (const auto& m : morphogens) {
+			for (const auto& center : m) {
+				out(center.first);
+				out(center.second);
+			}
+		}
+		out(static_cast<uint64_t>(w.cells.size()));
+		std::vector<const Cell*> byAddress(w.cells.begin(), w.cells.end());
+		std::sort(byAddress.begin(), byAddress.end(), std::less<const Cell*>());
+		std::vector<uint64_t> ranks(w.cells.size());
+		for (size_t r = 0; r < byAddress.size(); ++r) ranks[byAddress[r]->slot] = r;
+		out(ranks);
+		for (const auto& c : w.cells) c->saveState(out);  // (slots are in this order)
+		std::unordered_map<const Connection*, uint64_t> index;
+		out(static_cast<uint64_t>(w.cellCellConnections.size()));
+		for (const auto& con : w.cellCellConnections) {
+			const uint64_t i = index.size();
+			index[con.second.get()] = i;
+			out(static_cast<uint64_t>(con.second->cells.first->slot));
+			out(static_cast<uint64_t>(con.second->cells.second->slot));
+			out.bytes(*con.second);
+		}
+		for (const auto& c : w.cells) {
+			std::vector<uint64_t> own;
+			for (const auto* con : c->getMembrane().getCellCellConnectionManager().cellConnections)
+				own.push_back(index.at(con));
+			out(own);
+		}
+	}
+
+	// Replaces the simulation by a snapshot made by save, with a scenario using the same
+	// nutrient seed. Cells get back their exact state and their order by address, and
+	// connections are given back whole, joining the same cells (in contact or not) and
+	// listed in the same order by each cell, so that the run goes on along the same
+	// trajectory; --check-snapshot compares it step by step with the original run.
+	// On failure, the scenario is reset to the stem cell it had and false is returned.
+	bool restore(std::istream& is) {
+		SnapshotReader in(is);
+		uint64_t magic = 0, version = 0;
+		int seed = 0;
+		std::string dna;
+		in(magic);
+		in(version);
+		if (!in.ok() || magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+			std::cerr << "Not a snapshot, or made by another version." << std::endl;
+			return false;
+		}
+		in(seed);
+		in(dna);
+		if (!in.ok()) return restoreFailed(nullptr);
+		if (seed != options.nutrientSeed) {
+			std::cerr << "Snapshot made with nutrient seed " << seed << ", not "
+			          << options.nutrientSeed << "." << std::endl;
+			return false;
+		}
+		auto previousStem = std::move(stemCell);
+		stemCell = unique_ptr<Cell>(new Cell(CtrlType(dna)));
+		clear();
+		uint64_t steps = 0, frame = 0, nbMorphoCenters = 0, nbCells = 0;
+		in(simTime);
+		in(plantEnergy);
+		in(steps);
+		in(frame);
+		in(nutrientContent);
+		in(nbMorphoCenters);
+		for (uint64_t k = 0; k < nbMorphoCenters && in.ok(); ++k) {
+			std::array<std::pair<MecaCell::Vec, double>, Config::NB_MORPHOGENS> m{};
+			for (auto& center : m) {
+				in(center.first);
+				in(center.second);
+			}
+			morphogens.push_back(m);
+		}
+		in(nbCells);
+		if (!in.ok() || nutrientContent.size() != nutrientLayout->size())
+			return restoreFailed(std::move(previousStem));
+		std::vector<uint64_t> ranks;
+		in(ranks);
+		std::vector<bool> ranked(ranks.size(), false);
+		for (auto r : ranks) {
+			if (r >= ranks.size() || ranked[r]) in.fail();
+			else ranked[r] = true;
+		}
+		if (!in.ok() || ranks.size() != nbCells) return restoreFailed(std::move(previousStem));
+		nbSteps = steps;
+		w.frame = frame;
+		std::vector<Cell*> fresh;
+		for (uint64_t k = 0; k < nbCells; ++k) fresh.push_back(new Cell(stemCell->ctrl));
+		std::sort(fresh.begin(), fresh.end(), std::less<Cell*>());
+		for (auto r : ranks) w.addCell(fresh[r]);
+		adoptNewCells();
+		for (auto& c : w.cells) c->loadState(in, w.cells);
+		uint64_t nbConnections = 0;
+		in(nbConnections);
+		std::vector<Connection*> restored;
+		for (uint64_t k = 0; k < nbConnections && in.ok(); ++k) {
+			uint64_t first = 0, second = 0;
+			std::unique_ptr<Connection> con(new Connection());
+			in(first);
+			in(second);
+			in.bytes(*con);
+			if (first >= nbCells || second >= nbCells || first == second ||
+			    !std::less<Cell*>()(w.cells[first], w.cells[second])) {
+				in.fail();
+				break;
+			}
+			con->cells.first = w.cells[first];
+			con->cells.second = w.cells[second];
+			restored.push_back(con.get());
+			w.cellCellConnections[typename ConnectionMap::key_type{w.cells[first], w.cells[second]}] =
+			    std::move(con);
+		}
+		for (auto& c : w.cells) {
+			std::vector<uint64_t> own;
+			in(own);
+			auto& list = c->getMembrane().getCellCellConnectionManager().cellConnections;
+			list.clear();
+			for (auto i : own) {
+				if (i >= restored.size()) in.fail();
+				else list.push_back(restored[i]);
+			}
+		}
+		if (!in.ok()) return restoreFailed(std::move(previousStem));
+		for (auto& c : w.cells) {
+			if (c->sleeping)  // (the signature depends on the cells' addresses)
+				c->sleepNeighbours = c->computeNeighboursSignature();
+			for (auto& o : observers) o->onBirth(*c);
+		}
+		return true;
+	}
+
+	// Observers are told about what happens from the next step on, until the scenario is
+	// reset or terminated. They are not owned and must outlive their registration.
+	void addObserver(ScenarioObserver<Cell>* o) { observers.push_back(o); }
+
+	// f is called at the end of the first step after time t (in the order of the times)
+	void at(double t, std::function<void()> f) { timers.emplace(t, std::move(f)); }
+
+	void clearObservers() {
+		observers.clear();
+		timers.clear();
+	}
+
+	// the layout is shared by every scenario using the same seed, only contents are
+	// restored here
+	void resetNutrientsSources() {
+		nutrientContent.assign(nutrientLayout->initialContent.begin(),
+		                       nutrientLayout->initialContent.end());
+		reachableSources.clear();
+	}
+
+	// One scenario per thread, reused from one evaluation to the next.
+	static Scenario& threadLocal(Cell* stem, const ScenarioOptions& opts) {
+		thread_local std::unique_ptr<Scenario> sc;
+		if (!sc) {
+			sc = std::unique_ptr<Scenario>(new Scenario());
+			sc->setStemCell(stem);
+			sc->init(opts);
 		} else {
-			std::cerr << "No stem cell, aborting." << std::endl;
-			exit(1);
+			sc->reset(stem);
 		}
+		return *sc;
 	}
 
-	void initNutrientsSources() {
-		nutrientSources = std::vector<NutrientSource>();
-		if (Config::NB_NUTRIENTS_SOURCES > 0) {
-			auto internalRand = std::mt19937(randomSeed);
-			auto uniformDist = std::uniform_real_distribution<double>(-0.5, 0.5);
-			nutrientSources.push_back({stemCell->getPosition(),
-			                           std::pow(Config::TYPICAL_NUTRIENTS_RADIUS, 2),
-			                           Config::NUTRIENT_QUANTITY, Config::NUTRIENT_QUANTITY});
-
-			for (auto i = 1u; i < Config::NB_NUTRIENTS_SOURCES; ++i) {
-				MecaCell::Vec boundingCubeCenter(0.0, -Config::FIRST_NUTRIENT_SOURCE_THRESHOLD -
-				                                          Config::NUTRIENTS_BOUNDING_DEPTH * 0.5,
-				                                 0.0);
-				MecaCell::Vec rdmPos =
-				    boundingCubeCenter +
-				    MecaCell::Vec(uniformDist(internalRand) * Config::NUTRIENTS_BOUNDING_AREA,
-				                  uniformDist(internalRand) * Config::NUTRIENTS_BOUNDING_DEPTH,
-				                  uniformDist(internalRand) * Config::NUTRIENTS_BOUNDING_AREA);
-				double qtty =
-				    Config::NUTRIENT_QUANTITY *
-				    (1.0 + (pow(abs(rdmPos.y() + Config::FIRST_NUTRIENT_SOURCE_THRESHOLD),
-				                Config::NUTRIENT_DEPTH_INCREASE_POW) *
-				            Config::NUTRIENT_DEPTH_INCREASE_COEF));
-				nutrientSources.push_back(
-				    {rdmPos, std::pow(Config::TYPICAL_NUTRIENTS_RADIUS, 2), qtty, qtty});
+	// cells of the world which are not yet in this scenario's state table, or were just
+	// born, without telling the observers
+	void adoptNewCells() {
+		for (auto& c : w.cells) {
+			states.adopt(c);
+			c->justBorn = false;
+		}
+	}
+
+	// adoptNewCells at the end of a world update, reporting the births, deaths and moves
+	// of the step to the observers on the way. Daughters share their mother's table and
+	// are told apart by their justBorn flag.
+	void settleCells() {
+		if (observers.empty()) {
+			adoptNewCells();
+			return;
+		}
+		for (auto& c : w.cells) {
+			const bool born = c->justBorn || c->stateTable != &states;
+			states.adopt(c);
+			c->justBorn = false;
+			if (c->isDead()) {
+				if (!born)
+					for (auto& o : observers) o->onDeath(*c);
+			} else if (born) {
+				for (auto& o : observers) o->onBirth(*c);
+			} else if (!c->sleeping) {
+				for (auto& o : observers) o->onMove(*c);
 			}
 		}
-		// for (auto& n : nutrientSources) {
-		// stemCell->setPosition(n.pos);
-		// w.addCell(new Cell(*stemCell));
-		//}
+	}
+
+	// end of a step: observers, then the timers which are due
+	void stepDone() {
+		for (auto& o : observers) o->onStep(simTime, w.cells.size());
+		while (!timers.empty() && simTime > timers.begin()->first) {
+			auto f = std::move(timers.begin()->second);
+			timers.erase(timers.begin());
+			f();
+		}
+	}
+
+	// A source of content c > 0 has a positive intensity only closer than
+	// sqrt(sqradius * initialcontent / c) (sampling only shortens it). Sources farther
+	// than that from the cells' bounding box, widened by the sampling distance, contribute
+	// exactly 0 to sensing, absorption and gradients and are skipped. Cells only move at
+	// the end of a step and a skipped source keeps its content, so this is done once per
+	// step. An empty plant environment (e.g. a doomed plant far from any source) then
+	// costs nothing.
+	void updateReachableSources() {
+		reachableSources.clear();
+		if (w.cells.empty()) return;
+		using Box = std::pair<MecaCell::Vec, MecaCell::Vec>;  // (lo, hi) corners
+		const MecaCell::Vec& p0 = w.cells[0]->getPosition();
+		const Box box = PhaseExecutor::reduce(
+		    w.cells, Box(p0, p0), [](const Cell* c) { return Box(c->getPosition(), c->getPosition()); },
+		    [](Box a, const Box& b) {
+			    for (size_t k = 0; k < 3; ++k) {
+				    a.first.coords[k] = std::min(a.first.coords[k], b.first.coords[k]);
+				    a.second.coords[k] = std::max(a.second.coords[k], b.second.coords[k]);
+			    }
+			    return a;
+		    });
+		const MecaCell::Vec &lo = box.first, &hi = box.second;
+		const double margin = Config::NUTRIENT_SAMPLING_DIST;
+		for (size_t n = 0; n < nutrientContent.size(); ++n) {
+			const double content = nutrientContent[n];
+			if (content == 0.0) continue;
+			if (content > 0.0) {  // (an overdrawn source reaches everywhere)
+				const auto& p = nutrientLayout->pos[n];
+				double sqd = 0.0;
+				for (size_t k = 0; k < 3; ++k) {
+					double d = std::max({lo.coords[k] - margin - p.coords[k], 0.0,
+					                     p.coords[k] - hi.coords[k] - margin});
+					sqd += d * d;
+				}
+				// slightly widened, against rounding errors
+				const double sqReach = nutrientLayout->sqradius[n] *
+				                       nutrientLayout->initialContent[n] / content * (1.0 + 1e-9);
+				if (sqd >= sqReach) continue;
+			}
+			reachableSources.push_back(n);
+		}
 	}
 
 	void updateCellsSensedNutrients() {
-		for (auto& c : w.cells)
-			c->setSensedNutrients(WATER, computeNutrientIntensity(c->getPosition()));
+		auto& sensed = states.sensedNutrients[WATER];
+		PhaseExecutor::forIndex(states.size(), [&](size_t s) {
+			sensed[s] = computeNutrientIntensity(states.owner[s]->getPosition());
+		});
 	}
 
 	void terminate() {
+		clearObservers();
 		// auto end = std::chrono::system_clock::now();
 		// std::chrono::duration<double> diff = end - start;
 	}
@@ -150,6 +449,16 @@ template <typename Cell> class Scenario {
 	}
 
 	void shineOn() {
+		// only cells above ground can get light
+		const bool lit =
+		    PhaseExecutor::reduce(
+		        w.cells, size_t(0),
+		        [](const Cell* c) { return c->getPosition().y() > Config::EPSILON_GROUND ? size_t(1) : size_t(0); },
+		        [](size_t a, size_t b) { return a + b; }) > 0;
+		if (!lit) {
+			states.sensedNutrients[LIGHT].assign(states.size(), 0.0);
+			return;
+		}
 		const double resolution = MecaCell::DEFAULT_CELL_RADIUS;
 		unordered_map<std::pair<int, int>, Cell*> ybuffer;
 		for (auto& c : w.cells) {
@@ -179,9 +488,11 @@ template <typename Cell> class Scenario {
 		}
 	}
 
-	void diffuseNutrients() {
-		const auto dt = w.getDt();
-		for (auto& c : w.cells) {
+	void diffuseNutrients(double dt) {
+		auto& level = states.nutrientLevel;
+		auto& sensed = states.sensedNutrients;
+		for (size_t s = 0; s < states.size(); ++s) {
+			const auto* c = states.owner[s];
 			double freeArea = c->getMembrane().getCurrentArea();
 			for (const auto& con :
 			     c->getMembrane().getCellCellConnectionManager().cellConnections) {
@@ -189,82 +500,87 @@ template <typename Cell> class Scenario {
 			}
 			freeArea = std::max(0.0, freeArea);
 			// light to cell
-			if (c->sensedNutrients[LIGHT] > c->nutrientLevel[LIGHT]) {  // absorption only
-				double deltaP =
-				    max(0.0, c->nutrientLevel[LIGHT]) - max(0.0, c->sensedNutrients[LIGHT]);
+			if (sensed[LIGHT][s] > level[LIGHT][s]) {  // absorption only
+				double deltaP = max(0.0, level[LIGHT][s]) - max(0.0, sensed[LIGHT][s]);
 				auto Qn = diffusedQtty(deltaP, freeArea, c->getMembrane().getBaseRadius(), dt);
-				if (abs(Qn) > 10 || c->nutrientLevel[LIGHT] > 10) {
+				if (abs(Qn) > 10 || level[LIGHT][s] > 10) {
 					std::cerr << "diffusing light to cell " << c->id
-					          << ". c->lightLevel = " << c->nutrientLevel[LIGHT]
-					          << ", freeArea = " << freeArea
-					          << ", sensed = " << c->sensedNutrients[LIGHT]
+					          << ". c->lightLevel = " << level[LIGHT][s]
+					          << ", freeArea = " << freeArea << ", sensed = " << sensed[LIGHT][s]
 					          << ", deltaP = " << deltaP << ", Qn = " << Qn << std::endl;
 				}
-				c->deltaNutrient(LIGHT, Qn);
+				level[LIGHT][s] += Qn;
 			}
 			// water to cell
-			for (auto& wn : nutrientSources) {
-				if (wn.content > 0) {
-					auto pwater = computeNutrientIntensity(c->getPosition(), wn);
-					if (pwater > c->nutrientLevel[WATER]) {  // absorption only
-						double deltaP = max(0.0, c->nutrientLevel[WATER]) - max(0.0, pwater);
+			for (auto n : reachableSources) {
+				if (nutrientContent[n] > 0) {
+					auto pwater = computeNutrientIntensity(c->getPosition(), n);
+					if (pwater > level[WATER][s]) {  // absorption only
+						double deltaP = max(0.0, level[WATER][s]) - max(0.0, pwater);
 						auto Qn =
 						    diffusedQtty(deltaP, freeArea, c->getMembrane().getBaseRadius(), dt);
-						c->deltaNutrient(WATER, Qn);
-						if (abs(Qn) > 10 || c->nutrientLevel[WATER] > 10) {
+						level[WATER][s] += Qn;
+						if (abs(Qn) > 10 || level[WATER][s] > 10) {
 							std::cerr << "diffusing nutrients from grnd to cell " << c->id
-							          << ". c->nutrientLevel = " << c->nutrientLevel[WATER]
-							          << ", sensed = " << c->sensedNutrients[WATER]
-							          << ", deltaP = " << deltaP << ", Qn = " << Qn << std::endl;
+							          << ". c->nutrientLevel = " << level[WATER][s]
+							          << ", sensed = " << sensed[WATER][s] << ", deltaP = " << deltaP
+							          << ", Qn = " << Qn << std::endl;
 						}
-						wn.content -= Qn;
+						nutrientContent[n] -= Qn;
 					}
 				}
 			}
 		}
-		// cell to cell
-		for (size_t n = 0; n < Config::NB_NUTRIENTS; ++n) {
-			for (auto& con : w.cellCellConnections) {
-				if (con.second->adhCoef > 0.1) {  // true connection
-					double deltaP = max(0.0, con.first.second->nutrientLevel[n]) -
-					                max(0.0, con.first.first->nutrientLevel[n]);
-					auto Qn =
-					    diffusedQtty(deltaP, con.second->adhArea, con.second->centersDist, dt);
-					// if (abs(Qn) > 0) {
-					// std::cerr << "diffusing nutrients " << n << " from cell"
-					//<< con.second->cells.first->id << " to cell "
-					//<< con.second->cells.second->id << ", deltaP = " << deltaP
-					//<< ", Qn = " << Qn << std::endl;
-					// std::cerr << " first cell level = " << con.first.first->nutrientLevel[n]
-					//<< ", ";
-					// std::cerr << " secnd cell level = " << con.first.second->nutrientLevel[n]
-					//<< std::endl;
-					con.first.second->deltaNutrient(n, Qn);
-					con.first.first->deltaNutrient(n, -Qn);
-					// std::cerr << "AFTERDIF:" << std::endl;
-					// std::cerr << " first cell level = " << con.first.first->nutrientLevel[n]
-					//<< ", ";
-					// std::cerr << " secnd cell level = " << con.first.second->nutrientLevel[n]
-					//<< std::endl;
-					//}
+		diffuseBetweenCells(dt);
+	}
+
+	// cell to cell: fluxes are computed on every connection from the current levels,
+	// then each cell gathers the fluxes of its own connections, in connection order.
+	// Each flux is given to one cell and taken from the other, so mass is conserved.
+	// The graph is indexed by state table slots.
+	void diffuseBetweenCells(double dt) {
+		auto& level = states.nutrientLevel;
+		connections.refresh(states.owner, w.cellCellConnections);
+		connectionFlux.resize(connections.size());
+		PhaseExecutor::forIndex(connections.size(), [&](size_t e) {
+			auto& flux = connectionFlux[e];
+			flux.fill(0.0);
+			if (connections.adhCoef[e] > 0.1) {  // true connection
+				const auto s0 = connections.first[e];
+				const auto s1 = connections.second[e];
+				for (size_t n = 0; n < Config::NB_NUTRIENTS; ++n) {
+					double deltaP = max(0.0, level[n][s1]) - max(0.0, level[n][s0]);
+					flux[n] = diffusedQtty(deltaP, connections.adhArea[e],
+					                       connections.centersDist[e], dt);
 				}
 			}
-		}
+		});
+		PhaseExecutor::forIndex(states.size(), [&](size_t s) {
+			for (size_t k = connections.incidentStart[s]; k < connections.incidentStart[s + 1];
+			     ++k) {
+				const auto e = connections.incidentEdges[k];
+				const double sign = connections.second[e] == s ? 1.0 : -1.0;
+				for (size_t n = 0; n < Config::NB_NUTRIENTS; ++n)
+					level[n][s] += sign * connectionFlux[e][n];
+			}
+		});
 	}
 
-	double computeNutrientIntensity(const MecaCell::Vec& p, const NutrientSource& n,
+	// intensity of the nth nutrient source at p
+	double computeNutrientIntensity(const MecaCell::Vec& p, size_t n,
 	                                bool sampling = false) const {
 		if (p.y() > -Config::EPSILON_GROUND) return 0.0;
-		double sqd = (p - n.pos).sqlength();
+		const double content = nutrientContent[n];
+		double sqd = (p - nutrientLayout->pos[n]).sqlength();
 		// return max(0.0, 1.0 - (sqd / (n.sqradius * n.content / n.initialcontent)));
 		// return max(0.0, 1.0 - (sqd / (n.sqradius * n.content / n.initialcontent)));
-		double r = n.content / n.initialcontent;
+		double r = content / nutrientLayout->initialContent[n];
 		double coef = sampling ? Config::NUTRIENT_SAMPLING_COEF : 1.0;
-		return max(0.0, n.content * (1.0 - (sqd / n.sqradius * r * coef)) * r);
+		return max(0.0, content * (1.0 - (sqd / nutrientLayout->sqradius[n] * r * coef)) * r);
 	}
-	double computeNutrientIntensity(const MecaCell::Vec& p) {
+	double computeNutrientIntensity(const MecaCell::Vec& p) const {
 		double res = 0.0;
-		for (const auto& n : nutrientSources) res += computeNutrientIntensity(p, n);
+		for (auto n : reachableSources) res += computeNutrientIntensity(p, n);
 		return res;
 	}
 
@@ -295,9 +611,10 @@ template <typename Cell> class Scenario {
 	}
 
 	void applyGravity(double g) {
-		for (auto& c : w.cells)
+		PhaseExecutor::forEach(w.cells, [&](Cell* c) {
 			if (c->getPosition().y() > 0)
 				c->receiveExternalForce(MecaCell::Vec(0, -g * c->getMass(), 0));
+		});
 	}
 
 	void applyGroundReaction(Cell* c) {
@@ -313,36 +630,46 @@ template <typename Cell> class Scenario {
 		}
 	}
 
+	// GRN steps of all cells, ahead of the (serial) world behaviors update which
+	// handles divisions and deaths
+	void updateControllers() {
+		const unsigned int nbUpdates = scheduler.isDue(Subsystem::grn, nbSteps) ?
+		                                   scheduler.period(Subsystem::grn) :
+		                                   0;
+		PhaseExecutor::forEach(w.cells, [&](Cell* c) { c->updateController(nbUpdates); });
+	}
+
 	void worldupdate() {
 		w.prepareCellForNextUpdate();
 		applyGravity(Config::GRAVITY);
-		for (auto& c : w.cells) {
+		PhaseExecutor::forEach(w.cells, [&](Cell* c) {
 			if (c->getPosition().y() < 0) {
 				applyGroundReaction(c);
 			} else {
 				applyDrag(Config::AIR_VISCOSITY, c);
 			}
-		}
+		});
 		w.updateExistingCollisionsAndConnections();
+		if (options.sleeping)
+			PhaseExecutor::forEach(w.cells, [&](Cell* c) { c->updateSleep(Config::SIM_DT); });
 		for (auto& c : w.cells) {
+			if (c->sleeping) continue;
 			if (c->getPosition().y() < 0)
 				c->template updatePositionsAndOrientations<PosIntegrator>(Config::SIM_DT);
 			else
 				c->template updatePositionsAndOrientations<MecaCell::Euler>(Config::SIM_DT);
 		}
 		w.lookForNewCollisionsAndConnections();
+		updateControllers();
 		w.updateBehaviors();
+		settleCells();
 		w.destroyDeadCells();
+		states.compact();
 		w.frame++;
 	}
 
-	void loop() {
-		simTime += Config::SIM_DT;
-		updateCellsSensedNutrients();
-		shineOn();
-		diffuseNutrients();
-		std::vector<std::array<std::pair<MecaCell::Vec, double>, Config::NB_MORPHOGENS>>
-		    morphogens;
+	void updateMorphogens() {
+		morphogens.clear();
 		cellgrid.clear();
 		for (auto& c : w.cells) cellgrid.insertOnlyCenter(c);
 		auto gridcontent = cellgrid.getContent();
@@ -351,7 +678,7 @@ template <typename Cell> class Scenario {
 			for (auto& c : gridcell.second) {
 				for (auto i = 0u; i < Config::NB_MORPHOGENS; ++i) {
 					morphoCenters[i].first += c->getPosition();
-					morphoCenters[i].second += c->morphogensProduction[i];
+					morphoCenters[i].second += c->morphogenProduction(i);
 				}
 			}
 			if (gridcell.second.size() > 0) {
@@ -362,8 +689,67 @@ template <typename Cell> class Scenario {
 			}
 			morphogens.push_back(morphoCenters);
 		}
-		for (auto& c : w.cells) c->updateInputs(morphogens, this);
-		worldupdate();
+	}
+
+	void loop() {
+		simTime += Config::SIM_DT;
+		updateReachableSources();
+		if (scheduler.isDue(Subsystem::sensing, nbSteps)) updateCellsSensedNutrients();
+		if (scheduler.isDue(Subsystem::light, nbSteps)) shineOn();
+		if (scheduler.isDue(Subsystem::diffusion, nbSteps))
+			diffuseNutrients(w.getDt() * scheduler.period(Subsystem::diffusion));
+		if (scheduler.isDue(Subsystem::morphogens, nbSteps)) updateMorphogens();
+		PhaseExecutor::forEach(w.cells, [&](Cell* c) {
+			if (!c->sleeping) c->updateInputs(morphogens, this);
+		});
+		if (!(nbSteps == 0 && options.prescreen && prescreen())) worldupdate();
+		++nbSteps;
+		stepDone();
+	}
+
+	// Pre-screen of the stem cell, on the first step once its inputs are set. Its first
+	// controller update is run on a copy of the controller; nothing else in the step
+	// changes its inputs or outputs, so when this update leads to apoptosis (or the cell
+	// is already starving) the cell dies whatever the physics do: the world update is
+	// skipped and the scenario is left as the full step would have left it, empty.
+	// Otherwise, the copy goes on alone for Config::PRESCREEN_STEPS updates on these
+	// same, initial inputs to guess whether the plant will ever grow. This is only a
+	// prediction (inputs change in the real simulation) and is only reported.
+	// Returns true when the step is over.
+	bool prescreen() {
+		auto t0 = std::chrono::high_resolution_clock::now();
+		prescreenResult = PrescreenResult();
+		if (w.cells.size() != 1) return false;
+		Cell* c = w.cells[0];
+		if (c->currentStep() != CycleStep::quiescent || c->sleeping) return false;
+		prescreenResult.screened = true;
+		bool dies = c->isStarving();
+		if (!dies) {
+			CtrlType ctrl = c->ctrl;
+			size_t gradient = 0;
+			ctrl.update(scheduler.isDue(Subsystem::grn, nbSteps) ?
+			                scheduler.period(Subsystem::grn) :
+			                0);
+			auto fate = Cell::quiescentFate(ctrl, gradient);
+			dies = fate == Cell::Fate::die;
+			for (auto k = 0u; k < Config::PRESCREEN_STEPS; ++k) {
+				if (fate != Cell::Fate::quiescent) break;
+				ctrl.update();
+				fate = Cell::quiescentFate(ctrl, gradient);
+			}
+			prescreenResult.predictedInert = fate == Cell::Fate::quiescent;
+		}
+		if (dies) {
+			prescreenResult.diedAtOnce = true;
+			c->die();
+			for (auto& o : observers) o->onDeath(*c);
+			w.destroyDeadCells();
+			states.compact();
+			w.frame++;
+		}
+		auto t1 = std::chrono::high_resolution_clock::now();
+		prescreenResult.time = std::chrono::duration<double>(t1 - t0).count();
+		return dies;
 	}
 
 	void printState() {
@@ -376,11 +762,82 @@ template <typename Cell> class Scenario {
 	}
 
 	World& getWorld() { return w; }
+	const World& getWorld() const { return w; }
+	const ScenarioOptions& getOptions() const { return options; }
+	size_t getNbSleepingCells() const {
+		return PhaseExecutor::reduce(w.cells, size_t(0),
+		                             [](const Cell* c) { return c->sleeping ? size_t(1) : size_t(0); },
+		                             [](size_t a, size_t b) { return a + b; });
+	}
+	const Cell* getStemCell() const { return stemCell.get(); }
+
+	// Latest time at which a cell of a plant which can no longer divide can still be alive
+	// (infinity while it can divide). Such a plant is assumed to stay where it is: out of
+	// reach of the other sources and, when unlit, in the dark. Its reserves of a nutrient
+	// are what its cells hold plus what it can still absorb: the content of the sources
+	// reaching it (water), nothing or forever (light). Exchanges between cells keep them
+	// and a living cell consumes at least Config::NORMAL_NRJ_CONSUMPTION of each per
+	// second (Config::DIVISION_NRJ_CONSUMPTION while growing), so the last cell starves
+	// once the smallest reserves are spent. It can only divide if these reserves pay for
+	// the growth of one of its cells (PlantCell::minDivisionCost).
+	double latestDeathTime() {
+		const double inf = std::numeric_limits<double>::infinity();
+		if (w.cells.empty()) return simTime;
+		std::array<double, Config::NB_NUTRIENTS> reserves{};
+		double divisionCost = inf;
+		bool lit = false;
+		for (const auto* c : w.cells) {
+			for (size_t n = 0; n < Config::NB_NUTRIENTS; ++n)
+				reserves[n] += std::max(0.0, c->nutrientLevel(n));
+			divisionCost = std::min(divisionCost, c->minDivisionCost());
+			lit = lit || c->getPosition().y() > Config::EPSILON_GROUND;  // (as in shineOn)
+		}
+		if (lit) reserves[LIGHT] = inf;
+		// absorption only adds to the reserves: sources are only looked at for a plant
+		// which could not divide on its own
+		if (*std::min_element(reserves.begin(), reserves.end()) >= divisionCost) return inf;
+		updateReachableSources();
+		for (auto n : reachableSources) reserves[WATER] += std::max(0.0, nutrientContent[n]);
+		const double r = *std::min_element(reserves.begin(), reserves.end());
+		if (r >= divisionCost) return inf;
+		// a cell dies on the step after the one its levels drop below 0 on
+		const double stepCost = Config::NORMAL_NRJ_CONSUMPTION * Config::SIM_DT;
+		return simTime + (std::floor(r / stepCost) + 2.0) * Config::SIM_DT;
+	}
+
+	// Ends the run at the first step time from t on, as if every cell died then: the steps
+	// in between are counted, observers are told of the deaths and the timers due by then
+	// are run on the empty plant.
+	void fastForward(double t) {
+		const auto k = static_cast<unsigned long>(
+		    std::max(0.0, std::ceil((t - simTime) / Config::SIM_DT - 1e-9)));
+		simTime += static_cast<double>(k) * Config::SIM_DT;
+		nbSteps += k;
+		w.frame += k;
+		for (auto& c : w.cells) {
+			c->die();
+			for (auto& o : observers) o->onDeath(*c);
+		}
+		w.destroyDeadCells();
+		states.compact();
+		stepDone();
+	}
 
+	// With options.doom, a plant which can no longer divide is fast-forwarded to its latest
+	// death time once it falls within the simulation (its survival is then an upper bound
+	// of the exact one: it matches it for a lone cell starving out of reach of any source,
+	// but cells may choose to die or spend their reserves sooner).
 	bool finished() {
 		if (w.cells.size() == 0) return true;
 		if (w.cells.size() > maxCells) return true;
 		if (simTime > simDuration) return true;
+		if (options.doom) {
+			const double t = latestDeathTime();
+			if (t <= simDuration) {
+				fastForward(t);
+				return true;
+			}
+		}
 		return false;
 	}
 };
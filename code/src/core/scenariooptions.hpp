@@ -0,0 +1,96 @@
+#ifndef SCENARIOOPTIONS_HPP
+#define SCENARIOOPTIONS_HPP
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include "../external/cxxopts.hpp"
+#include "config.hpp"
+#include "scheduler.hpp"
+
+// Command line settings of a scenario. They are parsed once per run and then shared
+// by every scenario built or reset from them (typically one per evaluation thread).
+struct ScenarioOptions {
+	double simDuration = Config::DEFAULT_SIM_DURATION;
+	unsigned int maxCells = Config::DEFAULT_MAX_CELLS;
+	bool randomStem = false;  // random grn as stem cell
+	std::string stemFile;     // stem cell dna file
+	int nutrientSeed = 1000;  // layout of the nutrient sources
+	MultiRateScheduler rates;
+	bool sleeping = false;  // let cells at rest sleep (see PlantCell::updateSleep)
+	bool validate = false;  // also run the exact simulation and report the drift
+	bool prescreen = false;  // screen the stem cell's controller first (exact)
+	bool replay = false;  // staged evaluations start again from t = 0 (same results, slower)
+	bool doom = false;    // end doomed plants at their latest death time (see Scenario::finished)
+
+	// same settings without any approximation (every subsystem at full rate, no sleep,
+	// no doom)
+	ScenarioOptions exact() const {
+		ScenarioOptions res = *this;
+		res.rates.reset();
+		res.sleeping = false;
+		res.doom = false;
+		return res;
+	}
+
+	// the settings an evaluation depends on (not the stem cell, given by the GA), e.g. to
+	// tell apart cached evaluations made with other settings
+	std::string fingerprint() const {
+		std::ostringstream res;
+		res.precision(std::numeric_limits<double>::max_digits10);
+		res << "duration: " << simDuration << ", maxcell: " << maxCells
+		    << ", nutrient-seed: " << nutrientSeed << ", sleep: " << sleeping
+		    << ", prescreen: " << prescreen << ", replay: " << replay << ", doom: " << doom
+		    << ", "
+		    << rates.toString();
+		return res.str();
+	}
+
+	void addOptions(cxxopts::Options& options) {
+		options.add_options()("duration", "simulation duration",
+		                      cxxopts::value<double>(simDuration));
+		options.add_options()("maxcell", "max number of cells",
+		                      cxxopts::value<unsigned int>(maxCells));
+		options.add_options()("r,random", "random grn as stem cell",
+		                      cxxopts::value<bool>(randomStem));
+		options.add_options()("f,file", "stem cell dna from file",
+		                      cxxopts::value<std::string>(stemFile));
+		options.add_options()("nutrient-seed", "seed of the nutrient sources layout",
+		                      cxxopts::value<int>(nutrientSeed));
+		options.add_options()("sleep", "quiescent cells at rest stop being updated",
+		                      cxxopts::value<bool>(sleeping));
+		options.add_options()("validate",
+		                      "also run the exact simulation (full rates, no sleep) and report "
+		                      "the drift",
+		                      cxxopts::value<bool>(validate));
+		options.add_options()("prescreen",
+		                      "skip the physics of stem cells whose first update is apoptosis",
+		                      cxxopts::value<bool>(prescreen));
+		options.add_options()("replay",
+		                      "staged evaluations replay the simulation from the start instead "
+		                      "of restoring a snapshot (same results, no speedup)",
+		                      cxxopts::value<bool>(replay));
+		options.add_options()("doom",
+		                      "plants which can no longer divide end at the latest time their "
+		                      "reserves allow (survival is then an upper bound)",
+		                      cxxopts::value<bool>(doom));
+		rates.addOptions(options);
+	}
+
+	static ScenarioOptions parse(int argc, char** argv) {
+		ScenarioOptions res;
+		try {
+			cxxopts::Options options(argv[0]);
+			res.addOptions(options);
+			options.parse(argc, argv);
+		} catch (const cxxopts::OptionException& e) {
+			std::cout << "error parsing options: " << e.what() << std::endl;
+			exit(1);
+		} catch (const std::bad_cast& e) {
+			std::cout << "bad cast: " << e.what() << std::endl;
+			exit(1);
+		}
+		return res;
+	}
+};
+#endif
@@ -0,0 +1,67 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+#include <array>
+#include <string>
+#include <sstream>
+#include "../external/cxxopts.hpp"
+
+// Subsystems of a scenario step that can be updated less often than the physics.
+// Physics (forces, collisions, integration) and cell behaviors always run every step.
+enum class Subsystem { sensing, light, diffusion, morphogens, grn, count };
+
+// Each subsystem is updated once every "period" steps. In between, everything that
+// depends on it keeps using its last computed value (sensed nutrients, light, morphogen
+// grid, GRN outputs). Rate based subsystems (diffusion, GRN) are advanced by their
+// whole period when they run, so that their time scale is preserved.
+struct MultiRateScheduler {
+	std::array<unsigned int, static_cast<size_t>(Subsystem::count)> periods;
+
+	MultiRateScheduler() { periods.fill(1); }
+
+	static std::string name(Subsystem s) {
+		switch (s) {
+			case Subsystem::sensing:
+				return "sensing";
+			case Subsystem::light:
+				return "light";
+			case Subsystem::diffusion:
+				return "diffusion";
+			case Subsystem::morphogens:
+				return "morphogens";
+			case Subsystem::grn:
+				return "grn";
+			default:
+				return "unknown";
+		}
+	}
+
+	unsigned int period(Subsystem s) const { return periods[static_cast<size_t>(s)]; }
+	void setPeriod(Subsystem s, unsigned int p) {
+		periods[static_cast<size_t>(s)] = p > 0 ? p : 1;
+	}
+	void reset() { periods.fill(1); }
+	bool isDefault() const {
+		for (auto p : periods)
+			if (p != 1) return false;
+		return true;
+	}
+
+	// a subsystem is due on the first step and then every period steps
+	bool isDue(Subsystem s, unsigned long step) const { return step % period(s) == 0; }
+
+	void addOptions(cxxopts::Options& options) {
+		for (size_t s = 0; s < periods.size(); ++s) {
+			auto n = name(static_cast<Subsystem>(s));
+			options.add_options("rates")(n + "-period", "update " + n + " every n steps",
+			                             cxxopts::value<unsigned int>(periods[s]));
+		}
+	}
+
+	std::string toString() const {
+		std::ostringstream res;
+		for (size_t s = 0; s < periods.size(); ++s)
+			res << (s ? ", " : "") << name(static_cast<Subsystem>(s)) << ": " << periods[s];
+		return res.str();
+	}
+};
+#endif
@@ -0,0 +1,90 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Raw binary streams used by Scenario::save and Scenario::restore. Values are written
+// as they are in memory: a snapshot is only meant to be read back by the same build.
+struct SnapshotWriter {
+	std::ostream &os;
+	explicit SnapshotWriter(std::ostream &o) : os(o) {}
+
+	template <typename T> void operator()(const T &v) {
+		static_assert(std::is_trivially_copyable<T>::value, "not a plain value");
+		os.write(reinterpret_cast<const char *>(&v), sizeof(T));
+	}
+	template <typename T> void operator()(const std::vector<T> &v) {
+		static_assert(std::is_trivially_copyable<T>::value, "not a plain value");
+		(*this)(static_cast<uint64_t>(v.size()));
+		os.write(reinterpret_cast<const char *>(v.data()), sizeof(T) * v.size());
+	}
+	void operator()(const std::string &s) {
+		(*this)(static_cast<uint64_t>(s.size()));
+		os.write(s.data(), s.size());
+	}
+	// for objects made of plain values which are not trivially copyable in the strict
+	// sense (e.g. because of std::pair members)
+	template <typename T> void bytes(const T &v) {
+		static_assert(std::is_standard_layout<T>::value && std::is_trivially_destructible<T>::value,
+		              "not made of plain values");
+		os.write(reinterpret_cast<const char *>(&v), sizeof(T));
+	}
+};
+
+// Reads what a SnapshotWriter wrote. Once a read failed (truncated or corrupted
+// snapshot), every following read leaves its value untouched and ok() is false.
+struct SnapshotReader {
+	std::istream &is;
+	explicit SnapshotReader(std::istream &i) : is(i) {}
+
+	bool ok() const { return static_cast<bool>(is); }
+	// for values read fine but which cannot be given back
+	void fail() { is.setstate(std::ios::failbit); }
+
+	template <typename T> void operator()(T &v) {
+		static_assert(std::is_trivially_copyable<T>::value, "not a plain value");
+		T tmp;
+		if (is.read(reinterpret_cast<char *>(&tmp), sizeof(T))) v = tmp;
+	}
+	template <typename T> void operator()(std::vector<T> &v) {
+		static_assert(std::is_trivially_copyable<T>::value, "not a plain value");
+		const uint64_t n = size(sizeof(T));
+		if (!ok()) return;
+		v.resize(n);
+		is.read(reinterpret_cast<char *>(v.data()), sizeof(T) * n);
+	}
+	void operator()(std::string &s) {
+		const uint64_t n = size(1);
+		if (!ok()) return;
+		s.resize(n);
+		is.read(&s[0], n);
+	}
+	// what SnapshotWriter::bytes wrote
+	template <typename T> void bytes(T &v) {
+		static_assert(std::is_standard_layout<T>::value && std::is_trivially_destructible<T>::value,
+		              "not made of plain values");
+		char tmp[sizeof(T)];
+		if (is.read(tmp, sizeof(T))) std::memcpy(static_cast<void *>(&v), tmp, sizeof(T));
+	}
+
+ private:
+	// length of a sequence, rejected if longer than what remains in the stream
+	uint64_t size(size_t elementSize) {
+		uint64_t n = 0;
+		(*this)(n);
+		const auto pos = is.tellg();
+		if (ok() && pos >= 0) {
+			is.seekg(0, std::ios::end);
+			const auto end = is.tellg();
+			is.seekg(pos);
+			if (n > static_cast<uint64_t>(end - pos) / elementSize)
+				is.setstate(std::ios::failbit);
+		}
+		return n;
+	}
+};
+#endif
@@ -34,17 +34,31 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <assert.h>
+#include <cstdio>
 #include <vector>
+#include <bitset>
+#include <cstdint>
 #include <chrono>
 #include <fstream>
 #include <sstream>
 #include <unordered_set>
 #include <unordered_map>
 #include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <exception>
 #include <random>
 #include <utility>
 #include <map>
+#include <numeric>
+#include <queue>
 #include <string>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
 #include "json/json.hpp"
 
 #define PURPLE "\033[35m"
@@ -94,6 +108,401 @@ using std::chrono::system_clock;
 // #define OMP if you want OpenMP parallelisation
 // #define CLUSTER if you want MPI parralelisation
 
+/*****************************************************************************
+ *                         FOOTPRINT CLASS
+ * **************************************************************************/
+// Distance kernels on flat footprints of n values. Sums are spread over four independent
+// accumulators so that the compiler can keep them in vector registers.
+inline double sqDistance(const double *a, const double *b, size_t n) {
+	double s[4] = {0.0, 0.0, 0.0, 0.0};
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		for (size_t k = 0; k < 4; ++k) {
+			const double d = a[i + k] - b[i + k];
+			s[k] += d * d;
+		}
+	}
+	for (; i < n; ++i) s[0] += (a[i] - b[i]) * (a[i] - b[i]);
+	return (s[0] + s[1]) + (s[2] + s[3]);
+}
+inline double sqDistance(const double *a, const uint64_t *bits, size_t n) {
+	double s[4] = {0.0, 0.0, 0.0, 0.0};
+	for (size_t i = 0; i < n; ++i) {
+		const double d = a[i] - static_cast<double>((bits[i / 64] >> (i % 64)) & 1);
+		s[i % 4] += d * d;
+	}
+	return (s[0] + s[1]) + (s[2] + s[3]);
+}
+inline double sqDistance(const uint64_t *a, const uint64_t *b, size_t n) {
+	size_t hamming = 0;
+	for (size_t w = 0; w < (n + 63) / 64; ++w) hamming += std::bitset<64>(a[w] ^ b[w]).count();
+	return static_cast<double>(hamming);
+}
+// between footprints given by their values or their bits (when packed)
+inline double sqDistance(bool packed0, const double *values0, const uint64_t *bits0,
+                         bool packed1, const double *values1, const uint64_t *bits1, size_t n) {
+	if (packed0 && packed1) return sqDistance(bits0, bits1, n);
+	if (packed0) return sqDistance(values1, bits0, n);
+	if (packed1) return sqDistance(values0, bits1, n);
+	return sqDistance(values0, values1, n);
+}
+
+// An individual's behavior footprint, for novelty: one or more snapshots (vectors of
+// doubles, see GA::getFootprintDistance) set by the evaluator as an fpType. The values
+// of all the snapshots are stored one after the other, with the size of each snapshot
+// (its shape).
+// When every value is 0 or 1 (e.g. binarized captures), the footprint is stored as
+// packed bits and the euclidean distance between two such footprints is the square
+// root of their Hamming distance, counted with popcounts. Distances do not depend on
+// the representation.
+class Footprint {
+	vector<size_t> shape;   // size of each snapshot
+	size_t length = 0;      // total number of values
+	vector<double> values;  // unless packed
+	vector<uint64_t> bits;  // when packed
+	bool packed = false;
+
+ public:
+	Footprint() {}
+	Footprint(const fpType &f) { *this = f; }  // (implicit: evaluators set fpTypes)
+
+	Footprint &operator=(const fpType &f) {
+		shape.clear();
+		length = 0;
+		bool binary = !f.empty();
+		for (const auto &snapshot : f) {
+			shape.push_back(snapshot.size());
+			length += snapshot.size();
+			for (auto v : snapshot) binary = binary && (v == 0.0 || v == 1.0);
+		}
+		packed = binary;
+		values.clear();
+		bits.clear();
+		if (packed) bits.assign((length + 63) / 64, 0);
+		size_t k = 0;
+		for (const auto &snapshot : f) {
+			for (auto v : snapshot) {
+				if (!packed)
+					values.push_back(v);
+				else if (v == 1.0)
+					bits[k / 64] |= uint64_t(1) << (k % 64);
+				++k;
+			}
+		}
+		return *this;
+	}
+
+	bool isPacked() const { return packed; }
+	size_t size() const { return shape.size(); }  // number of snapshots
+	bool empty() const { return shape.empty(); }
+	size_t getLength() const { return length; }
+	const vector<size_t> &getShape() const { return shape; }
+	const double *data() const { return values.data(); }        // unless packed
+	const uint64_t *packedData() const { return bits.data(); }  // when packed
+
+	fpType toVector() const {
+		fpType res;
+		size_t k = 0;
+		for (auto n : shape) {
+			res.emplace_back();
+			res.back().reserve(n);
+			for (size_t i = 0; i < n; ++i, ++k)
+				res.back().push_back(packed ? static_cast<double>((bits[k / 64] >> (k % 64)) & 1) :
+				                              values[k]);
+		}
+		return res;
+	}
+
+	static void checkShapes(const vector<size_t> &s0, const vector<size_t> &s1) {
+		if (s0 != s1)
+			throw std::invalid_argument("footprints of different shapes (snapshots must "
+			                            "have the same size across individuals)");
+	}
+
+	// squared euclidean distance to a footprint of same shape given by its values or bits
+	double sqDistanceTo(bool otherPacked, const double *otherValues,
+	                    const uint64_t *otherBits) const {
+		return sqDistance(packed, values.data(), bits.data(), otherPacked, otherValues,
+		                  otherBits, length);
+	}
+
+	static double distance(const Footprint &f0, const Footprint &f1) {
+		checkShapes(f0.shape, f1.shape);
+		return sqrt(f0.sqDistanceTo(f1.packed, f1.values.data(), f1.bits.data()));
+	}
+};
+
+// Seeded Johnson-Lindenstrauss random projection of footprints to dim values, for novelty
+// in high-dimensional behavior spaces (e.g. captures): the distances between n footprints
+// are kept within a factor 1 +- eps with high probability once dim ~ log(n) / eps^2, and
+// are unbiased (same squared norms on average), so novelty thresholds keep their meaning.
+// The matrix is sparse (Achlioptas): entries are +-sqrt(3 / dim) with a probability of
+// 1/6 each, 0 otherwise. It is drawn for the length of the first footprint projected;
+// footprints not longer than dim are left as they are.
+class FootprintProjection {
+	size_t dim = 0;
+	unsigned int seed = 0;
+	size_t length = 0;       // of the footprints (0 = not drawn yet)
+	vector<size_t> start;    // of the entries of each input value
+	vector<uint32_t> target;  // output value of each entry
+	vector<double> weight;
+
+ public:
+	FootprintProjection() {}
+	FootprintProjection(size_t d, unsigned int s) : dim(d), seed(s) {}
+
+	bool enabled() const { return dim > 0; }
+	size_t getDim() const { return dim; }
+	bool reduces(const Footprint &f) const { return dim > 0 && f.getLength() > dim; }
+
+	// draws the matrix for footprints like f (not thread safe, call it once first)
+	void prepare(const Footprint &f) {
+		if (length > 0 || !reduces(f)) return;
+		length = f.getLength();
+		std::mt19937 rnd(seed);
+		std::uniform_int_distribution<int> die(0, 5);
+		const double w = sqrt(3.0 / static_cast<double>(dim));
+		start.assign(1, 0);
+		for (size_t i = 0; i < length; ++i) {
+			for (size_t j = 0; j < dim; ++j) {
+				int r = die(rnd);
+				if (r < 2) {
+					target.push_back(static_cast<uint32_t>(j));
+					weight.push_back(r == 0 ? w : -w);
+				}
+			}
+			start.push_back(target.size());
+		}
+	}
+
+	Footprint operator()(const Footprint &f) const {
+		if (!reduces(f)) return f;
+		assert(f.getLength() == length);
+		vector<double> res(dim, 0.0);
+		auto add = [&](size_t i, double v) {
+			for (size_t e = start[i]; e < start[i + 1]; ++e) res[target[e]] += weight[e] * v;
+		};
+		if (f.isPacked()) {
+			const uint64_t *b = f.packedData();
+			for (size_t i = 0; i < length; ++i)
+				if ((b[i / 64] >> (i % 64)) & 1) add(i, 1.0);
+		} else {
+			const double *v = f.data();
+			for (size_t i = 0; i < length; ++i)
+				if (v[i] != 0.0) add(i, v[i]);
+		}
+		return Footprint(fpType{res});
+	}
+};
+
+// Footprints of same shape as the rows of a matrix, e.g. a novelty archive: dense rows
+// are stored one after the other in one buffer, packed rows in another one.
+// Nearest neighbours are searched in a vantage point tree over the first rows (see
+// updateIndex) and by brute force among the others.
+class FootprintMatrix {
+	struct Query {  // a footprint or a row
+		bool packed;
+		const double *values;
+		const uint64_t *bits;
+	};
+	struct Row {
+		bool packed;
+		size_t offset;  // in values or bits
+	};
+	vector<size_t> shape;  // of every row (set by the first one)
+	size_t length = 0;
+	vector<double> values;
+	vector<uint64_t> bits;
+	vector<Row> rows;
+
+	struct VpNode {
+		size_t begin, end;  // its rows in vpRows, the vantage point first
+		double mu;          // median distance to the vantage point
+		int inside, outside;  // rows closer than mu, and the others (none for a leaf)
+	};
+	static constexpr size_t VP_LEAF_SIZE = 16;
+	static constexpr size_t VP_PROBES = 16;
+	size_t indexed = 0;  // rows in the tree
+	bool useTree = false;  // the tree does prune (see buildIndex)
+	vector<size_t> vpRows;
+	vector<VpNode> vpNodes;
+
+	using Neighbours = std::priority_queue<std::pair<double, size_t>>;  // worst on top
+
+ public:
+	size_t size() const { return rows.size(); }
+	const vector<size_t> &getShape() const { return shape; }  // (empty until a first row)
+
+	void push_back(const Footprint &f) {
+		if (rows.empty()) {
+			shape = f.getShape();
+			length = f.getLength();
+		}
+		Footprint::checkShapes(shape, f.getShape());
+		if (f.isPacked()) {
+			rows.push_back({true, bits.size()});
+			bits.insert(bits.end(), f.packedData(), f.packedData() + (length + 63) / 64);
+		} else {
+			rows.push_back({false, values.size()});
+			values.insert(values.end(), f.data(), f.data() + length);
+		}
+	}
+
+	// keeps the first n rows (n <= size())
+	void resize(size_t n) {
+		assert(n <= rows.size());
+		size_t nbValues = values.size(), nbBits = bits.size();
+		for (size_t r = n; r < rows.size(); ++r) {
+			if (rows[r].packed)
+				nbBits = std::min(nbBits, rows[r].offset);
+			else
+				nbValues = std::min(nbValues, rows[r].offset);
+		}
+		rows.resize(n);
+		values.resize(nbValues);
+		bits.resize(nbBits);
+		if (n < indexed) buildIndex(0, 0);
+	}
+
+	// euclidean distances of f to every row from the first one on
+	void distances(const Footprint &f, vector<double> &res, size_t first = 0) const {
+		res.clear();
+		if (first >= rows.size()) return;
+		Footprint::checkShapes(shape, f.getShape());
+		const Query q = query(f);
+		for (size_t r = first; r < rows.size(); ++r) res.push_back(distance(q, r));
+	}
+
+	// Rebuilds the tree over all the rows once the rows left out of it are more than a
+	// quarter of those in it; k is the number of neighbours which will be searched. Rows
+	// added afterwards are searched by brute force until the next rebuild.
+	void updateIndex(size_t k) {
+		const size_t minLeftOut = VP_LEAF_SIZE;
+		if (rows.size() - indexed > std::max(minLeftOut, indexed / 4))
+			buildIndex(rows.size(), k);
+	}
+
+	// Distances of f to its k nearest rows (k <= size()), in increasing order. They are
+	// the same as with bruteForce: the tree only skips rows which can not be closer than
+	// the kth neighbour found so far.
+	void nearest(const Footprint &f, size_t k, vector<double> &res,
+	             bool bruteForce = false) const {
+		res.clear();
+		if (rows.empty() || k == 0) return;
+		Footprint::checkShapes(shape, f.getShape());
+		if (bruteForce || !useTree) {
+			distances(f, res);
+			std::partial_sort(res.begin(), res.begin() + k, res.end());
+			res.resize(k);
+			return;
+		}
+		const Query q = query(f);
+		Neighbours knn;
+		size_t visited = 0;
+		for (size_t r = indexed; r < rows.size(); ++r) consider(q, r, k, knn);
+		search(0, q, k, knn, visited);
+		while (!knn.empty()) {
+			res.push_back(knn.top().first);
+			knn.pop();
+		}
+		std::reverse(res.begin(), res.end());
+	}
+
+ private:
+	static Query query(const Footprint &f) { return {f.isPacked(), f.data(), f.packedData()}; }
+	Query query(size_t r) const { return {rows[r].packed, rowValues(r), rowBits(r)}; }
+
+	// (the same for every footprint and row: the brute force and the tree agree)
+	double distance(const Query &q, size_t r) const {
+		return sqrt(sqDistance(q.packed, q.values, q.bits, rows[r].packed, rowValues(r),
+		                       rowBits(r), length));
+	}
+
+	const double *rowValues(size_t r) const {
+		return rows[r].packed ? nullptr : values.data() + rows[r].offset;
+	}
+	const uint64_t *rowBits(size_t r) const {
+		return rows[r].packed ? bits.data() + rows[r].offset : nullptr;
+	}
+
+	// The tree over the first n rows is only used if it does prune: in high dimensions
+	// a search can visit most rows, slower than brute force. This is estimated with a
+	// few of the rows as queries.
+	void buildIndex(size_t n, size_t k) {
+		indexed = n;
+		vpRows.resize(n);
+		std::iota(vpRows.begin(), vpRows.end(), 0);
+		vpNodes.clear();
+		vector<std::pair<double, size_t>> tmp;
+		useTree = false;
+		if (n == 0 || k == 0) return;
+		buildNode(0, n, tmp);
+		size_t visited = 0;
+		const size_t maxProbes = VP_PROBES, nbProbes = std::min(n, maxProbes);
+		for (size_t p = 0; p < nbProbes; ++p) {
+			Neighbours knn;
+			search(0, query(p * n / nbProbes), std::min(k, n), knn, visited);
+		}
+		useTree = visited * 2 < n * nbProbes;
+	}
+
+	int buildNode(size_t begin, size_t end, vector<std::pair<double, size_t>> &tmp) {
+		const int id = vpNodes.size();
+		vpNodes.push_back({begin, end, 0.0, -1, -1});
+		if (end - begin <= VP_LEAF_SIZE) return id;
+		const size_t vp = vpRows[begin];
+		tmp.clear();
+		for (size_t i = begin + 1; i < end; ++i)
+			tmp.emplace_back(distance(query(vp), vpRows[i]), vpRows[i]);
+		const size_t half = tmp.size() / 2;
+		std::nth_element(tmp.begin(), tmp.begin() + half, tmp.end());
+		for (size_t i = 0; i < tmp.size(); ++i) vpRows[begin + 1 + i] = tmp[i].second;
+		const double mu = tmp[half].first;
+		const size_t mid = begin + 1 + half;
+		const int inside = buildNode(begin + 1, mid, tmp);
+		const int outside = buildNode(mid, end, tmp);
+		vpNodes[id].mu = mu;
+		vpNodes[id].inside = inside;
+		vpNodes[id].outside = outside;
+		return id;
+	}
+
+	double consider(const Query &q, size_t r, size_t k, Neighbours &knn) const {
+		const double d = distance(q, r);
+		if (knn.size() < k) {
+			knn.emplace(d, r);
+		} else if (d < knn.top().first) {
+			knn.pop();
+			knn.emplace(d, r);
+		}
+		return d;
+	}
+
+	void search(int id, const Query &q, size_t k, Neighbours &knn, size_t &visited) const {
+		const auto &node = vpNodes[id];
+		if (node.inside < 0) {
+			for (size_t i = node.begin; i < node.end; ++i) consider(q, vpRows[i], k, knn);
+			visited += node.end - node.begin;
+			return;
+		}
+		const double d = consider(q, vpRows[node.begin], k, knn);
+		++visited;
+		// a child is skipped when its rows are provably farther than the kth neighbour
+		// (triangle inequality, widened against rounding errors)
+		const auto skip = [&](double lowerBound) {
+			return knn.size() == k &&
+			       lowerBound > knn.top().first + 1e-9 * (d + node.mu + knn.top().first);
+		};
+		if (d < node.mu) {
+			search(node.inside, q, k, knn, visited);
+			if (!skip(node.mu - d)) search(node.outside, q, k, knn, visited);
+		} else {
+			search(node.outside, q, k, knn, visited);
+			if (!skip(d - node.mu)) search(node.inside, q, k, knn, visited);
+		}
+	}
+};
+
 /*****************************************************************************
  *                         INDIVIDUAL CLASS
  * **************************************************************************/
@@ -108,11 +517,14 @@ using std::chrono::system_clock;
 template <typename DNA> struct Individual {
 	DNA dna;
 	map<string, double> fitnesses;  // map {"fitnessCriterName" -> "fitnessValue"}
-	fpType footprint;               // individual's footprint for novelty computation
+	Footprint footprint;            // individual's footprint for novelty computation
 	string infos;                   // custom infos, description, whatever...
 	bool evaluated = false;
 	bool wasAlreadyEvaluated = false;
 	double evalTime = 0.0;
+	double cost = 0.0;  // last evaluation time, or its parents' until evaluated
+	map<string, double> evalStats;  // evaluator's own stats (e.g. simulated time)
+	string evalState;  // where a staged evaluation stopped (opaque, not exported)
 
 	Individual() {}
 	explicit Individual(const DNA &d) : dna(d) {}
@@ -126,6 +538,8 @@ template <typename DNA> struct Individual {
 		if (o.count("evaluated")) evaluated = o.at("evaluated");
 		if (o.count("alreadyEval")) wasAlreadyEvaluated = o.at("alreadyEval");
 		if (o.count("evalTime")) evalTime = o.at("evalTime");
+		if (o.count("cost")) cost = o.at("cost");
+		if (o.count("evalStats")) evalStats = o.at("evalStats").get<decltype(evalStats)>();
 	}
 
 	// Exports individual to json
@@ -133,11 +547,13 @@ template <typename DNA> struct Individual {
 		json o;
 		o["dna"] = json::parse(dna.toJSON());
 		o["fitnesses"] = fitnesses;
-		o["footprint"] = footprint;
+		o["footprint"] = footprint.toVector();
 		o["infos"] = infos;
 		o["evaluated"] = evaluated;
 		o["alreadyEval"] = wasAlreadyEvaluated;
 		o["evalTime"] = evalTime;
+		o["cost"] = cost;
+		o["evalStats"] = evalStats;
 		return o;
 	}
 
@@ -160,6 +576,115 @@ template <typename DNA> struct Individual {
 	}
 };
 
+// LRU cache of evaluations (fitnesses, footprint and infos) keyed by a hash of the dna,
+// for deterministic evaluators (see GA::setEvaluationCache).
+class EvaluationCache {
+	struct Entry {
+		uint64_t key;
+		map<string, double> fitnesses;
+		Footprint footprint;
+		string infos;
+	};
+	size_t capacity = 0;       // 0 = disabled
+	std::list<Entry> entries;  // most recently used first
+	unordered_map<uint64_t, std::list<Entry>::iterator> index;
+
+	void put(Entry &&e) {
+		auto it = index.find(e.key);
+		if (it != index.end()) {
+			*it->second = std::move(e);
+			entries.splice(entries.begin(), entries, it->second);
+			return;
+		}
+		entries.push_front(std::move(e));
+		index[entries.front().key] = entries.begin();
+		while (entries.size() > capacity) {
+			index.erase(entries.back().key);
+			entries.pop_back();
+		}
+	}
+
+ public:
+	EvaluationCache() {}
+	explicit EvaluationCache(size_t c) : capacity(c) {}
+	// (the index points into entries: it is rebuilt for the copy)
+	EvaluationCache(const EvaluationCache &o) : capacity(o.capacity), entries(o.entries) {
+		for (auto it = entries.begin(); it != entries.end(); ++it) index[it->key] = it;
+	}
+	EvaluationCache(EvaluationCache &&) = default;
+	EvaluationCache &operator=(EvaluationCache o) {
+		capacity = o.capacity;
+		entries.swap(o.entries);
+		index.swap(o.index);
+		return *this;
+	}
+
+	bool enabled() const { return capacity > 0; }
+	size_t size() const { return entries.size(); }
+
+	// sets the individual's evaluation, if known
+	template <typename I> bool get(uint64_t key, I &ind) {
+		auto it = index.find(key);
+		if (it == index.end()) return false;
+		entries.splice(entries.begin(), entries, it->second);
+		ind.fitnesses = it->second->fitnesses;
+		ind.footprint = it->second->footprint;
+		ind.infos = it->second->infos;
+		return true;
+	}
+
+	template <typename I> void put(uint64_t key, const I &ind) {
+		put(Entry{key, ind.fitnesses, ind.footprint, ind.infos});
+	}
+
+	// One json object per line, least recently used first. The file is written aside
+	// then renamed, so that it is never left half written.
+	void save(const string &file, const string &evaluator, const string &settings) const {
+		const string tmp = file + ".tmp";
+		std::ofstream f(tmp);
+		for (auto e = entries.rbegin(); e != entries.rend(); ++e) {
+			json o;
+			o["evaluator"] = evaluator;
+			o["settings"] = settings;
+			o["key"] = e->key;
+			o["fitnesses"] = e->fitnesses;
+			o["footprint"] = e->footprint.toVector();
+			o["infos"] = e->infos;
+			f << o.dump() << "\n";
+		}
+		f.close();
+		if (!f || std::rename(tmp.c_str(), file.c_str()) != 0) {
+			std::cerr << "Could not save the evaluation cache to " << file << std::endl;
+			std::remove(tmp.c_str());
+		}
+	}
+
+	// Entries of other evaluators or made with other settings are ignored, and so are
+	// lines which can not be read.
+	void load(const string &file, const string &evaluator, const string &settings) {
+		std::ifstream f(file);
+		string line;
+		size_t unreadable = 0;
+		while (std::getline(f, line)) {
+			if (line.empty()) continue;
+			try {
+				auto o = json::parse(line);
+				if (o.at("evaluator").get<string>() != evaluator || !o.count("settings") ||
+				    o.at("settings").get<string>() != settings)
+					continue;
+				put(Entry{o.at("key").get<uint64_t>(),
+				          o.at("fitnesses").get<map<string, double>>(),
+				          Footprint(o.at("footprint").get<fpType>()),
+				          o.at("infos").get<string>()});
+			} catch (const std::exception &) {
+				++unreadable;
+			}
+		}
+		if (unreadable > 0)
+			std::cerr << "Skipped " << unreadable << " unreadable lines of " << file << std::endl;
+	}
+};
+
 /*********************************************************************************
  *                                 GA CLASS
  ********************************************************************************/
@@ -169,6 +694,10 @@ template <typename DNA> struct Individual {
 // constructor(int argc, char** argv)
 // void operator()(const Individual<DNA>& ind)
 // const string name
+// Optional, for staged evaluation (see setStagedEvaluation):
+// bool operator()(Individual<DNA>& ind, double horizon)
+// Optional DNA method, for the evaluation cache (see setEvaluationCache):
+// uint64_t canonicalHash() const
 //
 // TYPICAL USAGE :
 //
@@ -176,6 +705,20 @@ template <typename DNA> struct Individual {
 // ga.setPopSize(400);
 // return ga.start();
 
+// does the evaluator support staged evaluation?
+template <typename E, typename I, typename = void> struct hasStagedEvaluation : std::false_type {};
+template <typename E, typename I>
+struct hasStagedEvaluation<
+    E, I, decltype(static_cast<void>(std::declval<E &>()(std::declval<I &>(), 0.0)))>
+    : std::true_type {};
+
+// can the dna be looked up in an evaluation cache?
+template <typename D, typename = void> struct hasCanonicalHash : std::false_type {};
+template <typename D>
+struct hasCanonicalHash<
+    D, decltype(static_cast<void>(std::declval<const D &>().canonicalHash()))>
+    : std::true_type {};
+
 template <typename DNA, typename Evaluator> class GA {
  protected:
 	/*********************************************************************************
@@ -202,6 +745,21 @@ template <typename DNA, typename Evaluator> class GA {
 	                  // proportions contains the relative weights of the objectives
 	                  // if an objective is not present here but still used at evaluation
 	                  // a default non weighted average will be used
+	// staged evaluation (successive halving), see setStagedEvaluation
+	vector<double> stagedHorizons;    // empty = every individual is fully evaluated
+	double stagedKeepProportion = 0.5;
+	string stagedObjective;           // ranking objective (default: the first one)
+	bool stagedValidation = false;    // also fully evaluate culled individuals, for stats
+	// novelty on reduced footprints, see setNoveltyProjection
+	FootprintProjection projection;   // (disabled by default)
+	bool projectionValidation = false;  // also compute the exact novelty, for stats
+	// evaluation cache, see setEvaluationCache
+	EvaluationCache evaluationCache;  // (disabled by default)
+	string evaluationCacheFile;       // where it is kept between runs (optional)
+	string evaluationCacheSettings;   // what the evaluations depend on, besides the dna
+	// asynchronous steady state, see setSteadyState
+	bool steadyState = false;
+	unsigned int steadyReportInterval = 0;  // evaluations between reports (0 = popSize)
 	/********************************************************************************
 	 *                                 SETTERS
 	 ********************************************************************************/
@@ -230,13 +788,73 @@ template <typename DNA, typename Evaluator> class GA {
 	void setMinNoveltyForArchive(double m) { minNoveltyForArchive = m; }
 	void setObjectivesDistribution(map<string, double> d) { proportions = d; }
 	void setObjectivesDistribution(string o, double d) { proportions[o] = d; }
+	// Individuals are first evaluated up to horizons[0] only. At each horizon, the best
+	// keepProportion of those still running (on objective, or the first objective) go on
+	// to the next horizon, resuming where they stopped; after the last one they run to
+	// the end. The others keep the fitnesses reached so far, which the evaluator must
+	// make conservative estimates (e.g. the survival time so far). Ties are broken on
+	// the individuals' "promise" evalStat, if the evaluator sets one.
+	// The evaluator needs a bool operator()(Individual&, double horizon), which returns
+	// true once the evaluation is complete; without it, evaluation stays plain.
+	// With validation, culled individuals are also fully evaluated (without using the
+	// results) to measure how much the staged fitnesses change the selection.
+	void setStagedEvaluation(const vector<double> &horizons, double keepProportion = 0.5,
+	                         string objective = "", bool validation = false) {
+		stagedHorizons = horizons;
+		std::sort(stagedHorizons.begin(), stagedHorizons.end());
+		stagedKeepProportion =
+		    keepProportion <= 1.0 ? (keepProportion > 0.0 ? keepProportion : 0.0) : 1.0;
+		stagedObjective = objective;
+		stagedValidation = validation;
+	}
+	// Novelty is computed on seeded random projections of the footprints to dim values
+	// (see FootprintProjection), which is what the archive then stores. With validation,
+	// the exact novelty is also computed, over an archive of the same individuals, to
+	// measure the rank agreement and the time saved.
+	void setNoveltyProjection(size_t dim, unsigned int seed = 0, bool validation = false) {
+		projection = FootprintProjection(dim, seed);
+		projectionValidation = validation;
+	}
+	// Individuals whose dna has the same canonicalHash() as one already evaluated get its
+	// fitnesses, footprint and infos back from an LRU cache of the given capacity instead
+	// of being evaluated again, which requires a deterministic evaluator. The cache can
+	// be loaded from and saved to a file, to be kept between runs of the same evaluator;
+	// settings describes whatever else the evaluations depend on, and only entries made
+	// with the same settings are loaded.
+	void setEvaluationCache(size_t capacity, string file = "", string settings = "") {
+		evaluationCache = EvaluationCache(capacity);
+		evaluationCacheFile = file;
+		evaluationCacheSettings = settings;
+	}
+	// Asynchronous steady-state evolution instead of generations: each thread evaluates
+	// one individual at a time and, as soon as it is done, inserts it in the population
+	// (in place of the loser of an inverse tournament) with its novelty, then goes on
+	// with a new offspring of the current population. Every reportInterval evaluations
+	// (default: popSize), counted as a generation, the novelty of the population is
+	// refreshed and stats and saves are done as at the end of a generation, while the
+	// other threads keep evaluating. Not available with MPI; staged evaluation is not
+	// used in this mode.
+	void setSteadyState(bool enabled, unsigned int reportInterval = 0) {
+		steadyState = enabled;
+		steadyReportInterval = reportInterval;
+	}
+	Evaluator &getEvaluator() { return evaluate; }
 
 	////////////////////////////////////////////////////////////////////////////////////
 
  protected:
 	Evaluator evaluate;
-	vector<Individual<DNA>>
-	    archive;  // when novelty is enabled, we store the novel individuals there
+	// When novelty is enabled, the footprints of the novel individuals are kept in the
+	// archive, with where they come from. Their dna is only written to disk (see
+	// saveArchive).
+	struct ArchiveId {
+		unsigned int generation;
+		size_t index;  // in the population of that generation (steady state: evaluation number)
+	};
+	vector<ArchiveId> archiveIds;
+	FootprintMatrix archiveFootprints;  // of the archive, in the same order
+	vector<size_t> newlyArchived;  // indices of the individuals archived this generation
+	FootprintMatrix exactArchiveFootprints;  // unprojected, when validating the projection
 	vector<Individual<DNA>> population;
 	unsigned int currentGeneration = 0;
 	// openmp/mpi stuff
@@ -246,6 +864,14 @@ template <typename DNA, typename Evaluator> class GA {
 	char **argv = nullptr;
 
 	std::vector<std::map<std::string, std::map<std::string, double>>> genStats;
+	std::map<std::string, double> stagedStats;  // of the current generation
+	std::map<std::string, double> projectionStats;  // of the current generation
+	std::map<std::string, double> cacheStats;       // of the current generation
+	std::map<std::string, double> scheduleStats;    // of the current generation
+	vector<uint64_t> cacheKeys;  // of the individuals to evaluate and put in the cache
+	vector<std::pair<size_t, size_t>> cacheDuplicates;  // (copy, original) in population
+	vector<size_t> stagedCulled;  // individuals whose evaluation was stopped early
+	double totalSimulatedTime = 0.0;            // sum of the "simulatedTime" evalStats
 
 	std::random_device rd;
 	std::default_random_engine globalRand = std::default_random_engine(rd());
@@ -287,43 +913,32 @@ template <typename DNA, typename Evaluator> class GA {
 		if (procId == 0) {
 			createFolder(folder);
 			if (verbosity >= 1) printStart();
+			if (evaluationCache.enabled() && !evaluationCacheFile.empty())
+				evaluationCache.load(evaluationCacheFile, evaluate.name, evaluationCacheSettings);
+		}
+		if (steadyState && nbProcs == 1) {
+			runSteadyState();
+			finished = true;
 		}
 		while (!finished) {
 			auto tg0 = high_resolution_clock::now();
+			if (procId == 0) lookupEvaluations(hasCanonicalHash<DNA>());
 #ifdef CLUSTER
 			MPI_distributePopulation();
 #endif
-#ifdef OMP
-#pragma omp parallel for schedule(dynamic, 2)
-#endif
-			for (size_t i = 0; i < population.size(); ++i) {
-				if (!population[i].evaluated) {
-					auto t0 = high_resolution_clock::now();
-					population[i].dna.reset();
-					evaluate(population[i]);
-					auto t1 = high_resolution_clock::now();
-					population[i].evaluated = true;
-					double indTime = std::chrono::duration<double>(t1 - t0).count();
-					population[i].evalTime = indTime;
-					population[i].wasAlreadyEvaluated = false;
-				} else {
-					population[i].evalTime = 0.0;
-					population[i].wasAlreadyEvaluated = true;
-				}
-				if (verbosity >= 2) printIndividualStats(population[i]);
-			}
+			evaluatePopulation(hasStagedEvaluation<Evaluator, Individual<DNA>>());
 #ifdef CLUSTER
 			MPI_receivePopulation();
 #endif
 			if (procId == 0) {
+				cacheEvaluations();
 				if (novelty) updateNovelty();
 				auto tg1 = high_resolution_clock::now();
 				double totalTime = std::chrono::duration<double>(tg1 - tg0).count();
 				updateStats(totalTime);
-				if (currentGeneration % saveInterval == 0) {
-					if (savePopEnabled) savePop();
-					if (novelty && saveArchiveEnabled) saveArchive();
-				}
+				if (currentGeneration % saveInterval == 0 && savePopEnabled) savePop();
+				if (novelty && saveArchiveEnabled) saveArchive();
+				if (currentGeneration % saveInterval == 0) saveEvaluationCache();
 				if (verbosity >= 1) printGenStats(currentGeneration);
 				saveBests(nbSavedElites);
 				saveStats();
@@ -331,12 +946,629 @@ template <typename DNA, typename Evaluator> class GA {
 				finished = (currentGeneration++ >= nbGen);
 			}
 		}
+		if (procId == 0) saveEvaluationCache();
 #ifdef CLUSTER
 		MPI_Finalize();
 #endif
 		return 0;
 	}
 
+	/*********************************************************************************
+	 *                            STEADY STATE
+	 ********************************************************************************/
+	// Threads take turns (in a critical section) to insert their last evaluated
+	// individual and pick the next one: first the individuals of the initial population,
+	// then offspring. Evaluations themselves run in parallel. The population only holds
+	// evaluated individuals: it grows with the initial ones, then offspring replace others.
+	// Reports work on a copy of it, taken in the critical section, and are done outside of
+	// it by the thread which took the copy (one report at a time). Novelty searches too:
+	// a thread searches the archive as of the last report (indexed) after its evaluation,
+	// and only the footprints added since then and the population once it has the turn.
+	// The first exception of a thread stops the others and is rethrown at the end.
+	void runSteadyState() {
+		stagedHorizons.clear();
+		const size_t interval = steadyReportInterval > 0 ? steadyReportInterval : popSize;
+		const size_t budget = std::max<size_t>(interval * (nbGen + 1), population.size());
+		vector<Individual<DNA>> initial;
+		initial.swap(population);
+		vector<Individual<DNA>> live;  // (population is the copy of the current report)
+		live.reserve(popSize);
+		vector<Footprint> noveltyFootprints;  // of live (projected)
+		vector<size_t> evaluationIds;         // of live (number of their evaluation)
+		std::shared_ptr<const FootprintMatrix> archiveSnapshot;
+		if (novelty) {
+			auto a = std::make_shared<FootprintMatrix>(archiveFootprints);
+			a->updateIndex(KNN);
+			archiveSnapshot = std::move(a);
+		}
+		std::once_flag firstFootprint;
+		vector<size_t> footprintShape;  // (of the first one)
+		size_t nextInitial = 0, dispatched = 0, completed = 0, nextReport = interval;
+		unsigned int generation = currentGeneration;  // the one being filled
+		bool reporting = false;
+		std::exception_ptr failure;
+		size_t lookups = 0, hits = 0;
+		double busy = 0.0;
+		int nbThreads = 1;
+#ifdef OMP
+		nbThreads = omp_get_max_threads();
+#endif
+		auto tReport = high_resolution_clock::now();
+
+		// projects the individual's footprint to nf and sets the distances to its nearest
+		// footprints in the archive snapshot
+		auto searchSnapshot = [&](const Individual<DNA> &ind, const FootprintMatrix &snapshot,
+		                          Footprint &nf, vector<double> &snapshotDists) {
+			std::call_once(firstFootprint, [&]() {
+				footprintShape = ind.footprint.getShape();
+				if (projection.enabled()) projection.prepare(ind.footprint);
+			});
+			Footprint::checkShapes(footprintShape, ind.footprint.getShape());
+			nf = projection.enabled() ? projection(ind.footprint) : ind.footprint;
+			snapshot.nearest(nf, std::min<size_t>(KNN, snapshot.size()), snapshotDists);
+		};
+
+		// (in the critical section) average distance of nf to its KNN nearest footprints
+		// among the archive, the population and itself, as computeAvgDist would give
+		auto avgDist = [&](const Footprint &nf, size_t snapshotSize,
+		                   const vector<double> &snapshotDists) {
+			const size_t total = archiveFootprints.size() + noveltyFootprints.size() + 1;
+			if (total <= 1) return 0.0;
+			vector<double> d;
+			archiveFootprints.distances(nf, d, snapshotSize);
+			d.insert(d.end(), snapshotDists.begin(), snapshotDists.end());
+			for (const auto &f : noveltyFootprints) d.push_back(Footprint::distance(nf, f));
+			d.push_back(0.0);  // (itself)
+			const size_t k = std::min<size_t>(KNN, total);
+			std::partial_sort(d.begin(), d.begin() + k, d.end());
+			double sum = 0.0;
+			for (size_t i = 0; i < k; ++i) sum += d[i];
+			return sum / static_cast<double>(k);
+		};
+
+		// sets the individual's novelty, puts it in the population (in place of an inverse
+		// tournament loser once full) and archives it if novel enough
+		auto insert = [&](Individual<DNA> &ind, Footprint &nf, size_t snapshotSize,
+		                  const vector<double> &snapshotDists) {
+			const size_t id = completed++;
+			ind.evaluated = true;
+			ind.wasAlreadyEvaluated = false;
+			if (novelty) ind.fitnesses["novelty"] = avgDist(nf, snapshotSize, snapshotDists);
+			size_t slot = live.size();
+			if (slot < popSize) {
+				live.push_back(std::move(ind));
+				noveltyFootprints.push_back(std::move(nf));
+				evaluationIds.push_back(id);
+			} else {
+				slot = inverseTournament(live);
+				live[slot] = std::move(ind);
+				noveltyFootprints[slot] = std::move(nf);
+				evaluationIds[slot] = id;
+			}
+			if (novelty && live[slot].fitnesses.at("novelty") > minNoveltyForArchive) {
+				archiveIds.push_back({generation, id});
+				archiveFootprints.push_back(noveltyFootprints[slot]);
+				if (saveArchiveEnabled) appendToArchive(live[slot], generation, id);
+			}
+			if (verbosity >= 2) printIndividualStats(live[slot]);
+		};
+
+		// what a report needs besides the population, copied with it
+		struct ReportData {
+			unsigned int generation = 0;
+			vector<size_t> evaluationIds;
+			vector<Footprint> footprints;
+			FootprintMatrix archive;
+			bool saveCache = false;
+			EvaluationCache cache;
+			map<string, double> scheduleStats, cacheStats;
+			double wall = 0.0;
+		};
+
+		// (in the critical section) copies the population and what goes with it
+		auto takeReport = [&](ReportData &r) {
+			auto t = high_resolution_clock::now();
+			r.wall = std::chrono::duration<double>(t - tReport).count();
+			tReport = t;
+			r.generation = generation++;
+			population = live;
+			r.evaluationIds = evaluationIds;
+			if (novelty) {
+				r.footprints = noveltyFootprints;
+				r.archive = archiveFootprints;
+			}
+			r.saveCache = r.generation % saveInterval == 0 && evaluationCache.enabled() &&
+			              !evaluationCacheFile.empty();
+			if (r.saveCache) r.cache = evaluationCache;
+			r.scheduleStats = {{"evalWallTime", r.wall},
+			                   {"idleTime", std::max(0.0, r.wall * nbThreads - busy)}};
+			busy = 0.0;
+			r.cacheStats.clear();
+			if (evaluationCache.enabled() && hasCanonicalHash<DNA>::value) {
+				r.cacheStats["lookups"] = lookups;
+				r.cacheStats["hits"] = hits;
+				r.cacheStats["hitRate"] = lookups > 0 ? static_cast<double>(hits) / lookups : 0.0;
+				r.cacheStats["size"] = evaluationCache.size();
+				lookups = hits = 0;
+			}
+			for (auto &ind : live) ind.wasAlreadyEvaluated = true;
+			nextReport += interval;
+			reporting = true;
+		};
+
+		// (outside) refreshes the copy's novelty and does what ends a generation
+		auto report = [&](ReportData &r) {
+			currentGeneration = r.generation;
+			if (novelty) {
+				auto novel = computeNovelty(r.archive, [&](size_t i) -> const Footprint & {
+					return r.footprints[i];
+				});
+				for (size_t i = 0; i < population.size(); ++i)
+					population[i].fitnesses["novelty"] = novel[i];
+			}
+			scheduleStats = r.scheduleStats;
+			cacheStats = r.cacheStats;
+			updateStats(r.wall);
+			if (currentGeneration % saveInterval == 0 && savePopEnabled) savePop();
+			if (r.saveCache) r.cache.save(evaluationCacheFile, evaluate.name, evaluationCacheSettings);
+			if (verbosity >= 1) printGenStats(currentGeneration);
+			saveBests(nbSavedElites);
+			saveStats();
+		};
+
+		// (in the critical section) gives the refreshed novelty back to the individuals
+		// which are still in the population, and the archive (now indexed) to the searches
+		auto endReport = [&](ReportData &r, bool done) {
+			if (novelty && done) {
+				for (size_t i = 0; i < r.evaluationIds.size(); ++i)
+					if (evaluationIds[i] == r.evaluationIds[i])
+						live[i].fitnesses["novelty"] = population[i].fitnesses.at("novelty");
+				archiveSnapshot = std::make_shared<const FootprintMatrix>(std::move(r.archive));
+			}
+			reporting = false;
+		};
+
+		// (in the critical section, in a handler) keeps the first exception
+		auto fail = [&]() {
+			if (!failure) failure = std::current_exception();
+		};
+
+#ifdef OMP
+#pragma omp parallel
+#endif
+		{
+			Individual<DNA> ind;
+			uint64_t key = 0;
+			bool working = false;
+			double evalTime = 0.0;
+			ReportData r;
+			std::shared_ptr<const FootprintMatrix> snapshot;  // (searched for ind)
+			Footprint nf;
+			vector<double> snapshotDists;
+			while (true) {
+				bool reporter = false;
+#ifdef OMP
+#pragma omp critical(gagaSteadyState)
+#endif
+				{
+					try {
+						if (working) {
+							working = false;
+							busy += evalTime;
+							if (key) evaluationCache.put(key, ind);
+							insert(ind, nf, snapshot ? snapshot->size() : 0, snapshotDists);
+						}
+						while (!working && !failure && dispatched < budget) {
+							// next individual: initial ones first, then offspring
+							if (nextInitial < initial.size())
+								ind = std::move(initial[nextInitial++]);
+							else if (live.empty())  // (all initial ones still running)
+								ind = Individual<DNA>(DNA::random(argc, argv));
+							else
+								ind = steadyOffspring(live);
+							++dispatched;
+							key = 0;
+							if (lookupEvaluation(ind, key, hasCanonicalHash<DNA>())) {
+								++lookups;
+								++hits;
+								ind.evalTime = 0.0;
+								snapshot = archiveSnapshot;
+								if (novelty) searchSnapshot(ind, *snapshot, nf, snapshotDists);
+								insert(ind, nf, snapshot ? snapshot->size() : 0, snapshotDists);
+							} else {
+								if (key) ++lookups;
+								snapshot = archiveSnapshot;
+								working = true;
+							}
+						}
+						if (!reporting && !failure && !live.empty() &&
+						    (completed >= nextReport || completed == budget) && generation <= nbGen) {
+							takeReport(r);
+							reporter = true;
+						}
+					} catch (...) {
+						working = false;
+						fail();
+					}
+				}
+				if (reporter) {
+					bool done = true;
+					try {
+						report(r);
+					} catch (...) {
+						done = false;
+#ifdef OMP
+#pragma omp critical(gagaSteadyState)
+#endif
+						fail();
+					}
+#ifdef OMP
+#pragma omp critical(gagaSteadyState)
+#endif
+					endReport(r, done);
+					if (!working) continue;  // (a report may be due again)
+				}
+				if (!working) break;
+				try {
+					auto t0 = high_resolution_clock::now();
+					ind.dna.reset();
+					ind.evalStats.clear();
+					evaluate(ind);
+					auto t1 = high_resolution_clock::now();
+					evalTime = std::chrono::duration<double>(t1 - t0).count();
+					ind.evalTime = evalTime;
+					ind.cost = evalTime;
+					if (novelty) searchSnapshot(ind, *snapshot, nf, snapshotDists);
+				} catch (...) {
+					working = false;
+#ifdef OMP
+#pragma omp critical(gagaSteadyState)
+#endif
+					fail();
+				}
+			}
+		}
+		currentGeneration = generation;
+		if (failure) std::rethrow_exception(failure);
+	}
+
+	// offspring of two tournament winners of pop, as in multiObjTournament
+	// (but never a plain copy of its parent)
+	Individual<DNA> steadyOffspring(vector<Individual<DNA>> &pop) {
+		std::uniform_real_distribution<double> d(0.0, 1.0);
+		std::uniform_int_distribution<size_t> dint(0, pop.size() - 1);
+		vector<string> objNames;
+		for (const auto &o : pop[0].fitnesses) objNames.push_back(o.first);
+		std::uniform_int_distribution<size_t> dObj(0, objNames.size() - 1);
+		auto winner = [&]() {
+			const string &obj = objNames[dObj(globalRand)];
+			Individual<DNA> *w = &pop[dint(globalRand)];
+			for (unsigned int i = 1; i < tournamentSize; ++i) {
+				Individual<DNA> *c = &pop[dint(globalRand)];
+				if (isBetter(c->fitnesses.at(obj), w->fitnesses.at(obj))) w = c;
+			}
+			return w;
+		};
+		Individual<DNA> *p0 = winner();
+		Individual<DNA> *p1 = winner();
+		Individual<DNA> offspring;
+		if (d(globalRand) < crossoverProba) {
+			offspring = Individual<DNA>(p0->dna.crossover(p1->dna));
+			offspring.cost = 0.5 * (p0->cost + p1->cost);
+			if (d(globalRand) < mutationProba) offspring.dna.mutate();
+		} else {
+			offspring = Individual<DNA>(p0->dna);
+			offspring.cost = p0->cost;
+			offspring.dna.mutate();
+		}
+		return offspring;
+	}
+
+	// the worst of tournamentSize individuals of pop, on a random objective
+	size_t inverseTournament(const vector<Individual<DNA>> &pop) {
+		std::uniform_int_distribution<size_t> dint(0, pop.size() - 1);
+		const auto &fitnesses = pop[0].fitnesses;
+		std::uniform_int_distribution<size_t> dObj(0, fitnesses.size() - 1);
+		auto o = fitnesses.begin();
+		std::advance(o, dObj(globalRand));
+		const string obj = o->first;
+		size_t loser = dint(globalRand);
+		for (unsigned int i = 1; i < tournamentSize; ++i) {
+			size_t c = dint(globalRand);
+			if (isBetter(pop[loser].fitnesses.at(obj), pop[c].fitnesses.at(obj)))
+				loser = c;
+		}
+		return loser;
+	}
+
+	/*********************************************************************************
+	 *                            EVALUATION
+	 ********************************************************************************/
+	// Individuals found in the evaluation cache, or whose copy is already going to be
+	// evaluated in this generation, are marked as evaluated.
+	void lookupEvaluations(std::false_type) { cacheKeys.clear(); }
+	void lookupEvaluations(std::true_type) {
+		cacheKeys.clear();
+		cacheDuplicates.clear();
+		cacheStats.clear();
+		if (!evaluationCache.enabled()) return;
+		cacheKeys.assign(population.size(), 0);
+		unordered_map<uint64_t, size_t> toEvaluate;
+		size_t lookups = 0, hits = 0;
+		for (size_t i = 0; i < population.size(); ++i) {
+			auto &ind = population[i];
+			if (ind.evaluated) continue;
+			const uint64_t key = ind.dna.canonicalHash();
+			++lookups;
+			auto original = toEvaluate.find(key);
+			if (original != toEvaluate.end()) {
+				cacheDuplicates.push_back({i, original->second});
+			} else if (!evaluationCache.get(key, ind)) {
+				cacheKeys[i] = key;
+				toEvaluate[key] = i;
+				continue;
+			}
+			ind.evaluated = true;
+			ind.evalStats.clear();
+			++hits;
+		}
+		cacheStats["lookups"] = lookups;
+		cacheStats["hits"] = hits;
+		cacheStats["hitRate"] = lookups > 0 ? static_cast<double>(hits) / lookups : 0.0;
+	}
+
+	// sets the individual's evaluation if it is in the cache, else its key (to put it in)
+	bool lookupEvaluation(Individual<DNA> &, uint64_t &, std::false_type) { return false; }
+	bool lookupEvaluation(Individual<DNA> &ind, uint64_t &key, std::true_type) {
+		if (!evaluationCache.enabled()) return false;
+		key = ind.dna.canonicalHash();
+		if (!evaluationCache.get(key, ind)) return false;
+		key = 0;
+		return true;
+	}
+
+	// puts the new complete evaluations in the cache
+	void cacheEvaluations() {
+		if (cacheKeys.empty()) return;
+		for (const auto &d : cacheDuplicates) {
+			auto &ind = population[d.first];
+			const auto &original = population[d.second];
+			ind.fitnesses = original.fitnesses;
+			ind.footprint = original.footprint;
+			ind.infos = original.infos;
+		}
+		cacheStats["size"] = evaluationCache.size();
+#ifdef CLUSTER
+		if (!stagedHorizons.empty()) return;  // (culled individuals are not known here)
+#endif
+		for (auto i : stagedCulled) cacheKeys[i] = 0;
+		for (size_t i = 0; i < population.size(); ++i)
+			if (cacheKeys[i] && !population[i].wasAlreadyEvaluated)
+				evaluationCache.put(cacheKeys[i], population[i]);
+		cacheStats["size"] = evaluationCache.size();
+	}
+
+	void saveEvaluationCache() {
+		if (evaluationCache.enabled() && !evaluationCacheFile.empty())
+			evaluationCache.save(evaluationCacheFile, evaluate.name, evaluationCacheSettings);
+	}
+
+	// Runs evaluation(i) for each i of toEvaluate on every thread, by decreasing predicted
+	// cost (longest processing time first): a thread takes the next individual as soon
+	// as it is done, so that long evaluations do not start last and keep one thread
+	// busy at the end of the generation. Wall and idle time of the threads are added to
+	// scheduleStats.
+	template <typename F>
+	void scheduleEvaluations(vector<size_t> toEvaluate, const F &evaluation) {
+		std::stable_sort(toEvaluate.begin(), toEvaluate.end(), [&](size_t a, size_t b) {
+			return population[a].cost > population[b].cost;
+		});
+		int nbThreads = 1;
+#ifdef OMP
+		nbThreads = omp_get_max_threads();
+#endif
+		double busy = 0.0;
+		auto t0 = high_resolution_clock::now();
+#ifdef OMP
+#pragma omp parallel for schedule(dynamic, 1) reduction(+ : busy)
+#endif
+		for (size_t k = 0; k < toEvaluate.size(); ++k) {
+			auto b0 = high_resolution_clock::now();
+			evaluation(toEvaluate[k]);
+			auto b1 = high_resolution_clock::now();
+			busy += std::chrono::duration<double>(b1 - b0).count();
+		}
+		auto t1 = high_resolution_clock::now();
+		const double wall = std::chrono::duration<double>(t1 - t0).count();
+		scheduleStats["evalWallTime"] += wall;
+		scheduleStats["idleTime"] += std::max(0.0, wall * nbThreads - busy);
+	}
+
+	void evaluatePopulation(std::false_type) {
+		scheduleStats = {{"evalWallTime", 0.0}, {"idleTime", 0.0}};
+		vector<size_t> toEvaluate;
+		for (size_t i = 0; i < population.size(); ++i) {
+			if (!population[i].evaluated) {
+				toEvaluate.push_back(i);
+			} else {
+				population[i].evalTime = 0.0;
+				population[i].wasAlreadyEvaluated = true;
+				if (verbosity >= 2) printIndividualStats(population[i]);
+			}
+		}
+		scheduleEvaluations(toEvaluate, [&](size_t i) {
+			auto t0 = high_resolution_clock::now();
+			population[i].dna.reset();
+			evaluate(population[i]);
+			auto t1 = high_resolution_clock::now();
+			population[i].evaluated = true;
+			double indTime = std::chrono::duration<double>(t1 - t0).count();
+			population[i].evalTime = indTime;
+			population[i].cost = indTime;
+			population[i].wasAlreadyEvaluated = false;
+			if (verbosity >= 2) printIndividualStats(population[i]);
+		});
+	}
+
+	void evaluatePopulation(std::true_type) {
+		if (stagedHorizons.empty()) {
+			evaluatePopulation(std::false_type());
+			return;
+		}
+		stagedStats.clear();
+		stagedCulled.clear();
+		scheduleStats = {{"evalWallTime", 0.0}, {"idleTime", 0.0}};
+		vector<size_t> running;
+		for (size_t i = 0; i < population.size(); ++i) {
+			auto &ind = population[i];
+			ind.evalTime = 0.0;
+			ind.wasAlreadyEvaluated = ind.evaluated;
+			if (ind.evaluated) continue;
+			ind.dna.reset();
+			ind.evalStats.clear();
+			ind.evalState.clear();
+			running.push_back(i);
+		}
+		vector<size_t> culled;
+		const size_t nbRungs = stagedHorizons.size() + 1;
+		for (size_t r = 0; r < nbRungs && !running.empty(); ++r) {
+			const double horizon = r < stagedHorizons.size() ?
+			                           stagedHorizons[r] :
+			                           std::numeric_limits<double>::infinity();
+			vector<char> complete(population.size(), false);
+			scheduleEvaluations(running, [&](size_t i) {
+				auto &ind = population[i];
+				auto t0 = high_resolution_clock::now();
+				complete[i] = evaluate(ind, horizon);
+				auto t1 = high_resolution_clock::now();
+				ind.evalTime += std::chrono::duration<double>(t1 - t0).count();
+			});
+			vector<size_t> next;
+			for (size_t k = 0; k < running.size(); ++k) {
+				if (complete[running[k]] || r == nbRungs - 1)
+					population[running[k]].evaluated = true;
+				else
+					next.push_back(running[k]);
+			}
+			if (next.empty()) break;
+			// the best ones go on, the others keep their current (partial) fitnesses
+			const string obj =
+			    stagedObjective.empty() ? population[next[0]].fitnesses.begin()->first :
+			                              stagedObjective;
+			auto promise = [&](size_t i) {
+				const auto &st = population[i].evalStats;
+				return st.count("promise") ? st.at("promise") : 0.0;
+			};
+			std::stable_sort(next.begin(), next.end(), [&](size_t a, size_t b) {
+				const double fa = population[a].fitnesses.at(obj);
+				const double fb = population[b].fitnesses.at(obj);
+				return fa == fb ? isBetter(promise(a), promise(b)) : isBetter(fa, fb);
+			});
+			const size_t nbKept = static_cast<size_t>(
+			    std::ceil(static_cast<double>(next.size()) * stagedKeepProportion));
+			for (size_t k = nbKept; k < next.size(); ++k) {
+				auto &ind = population[next[k]];
+				ind.evaluated = true;
+				ind.evalState.clear();
+				culled.push_back(next[k]);
+			}
+			next.resize(nbKept);
+			running = next;
+		}
+		// costs (the culled ones stopped early, their parents' cost may be closer)
+		vector<char> stopped(population.size(), false);
+		for (auto i : culled) stopped[i] = true;
+		for (size_t i = 0; i < population.size(); ++i) {
+			auto &ind = population[i];
+			if (!ind.wasAlreadyEvaluated)
+				ind.cost = stopped[i] ? std::max(ind.cost, ind.evalTime) : ind.evalTime;
+		}
+		stagedStats["culled"] = culled.size();
+		stagedCulled = culled;
+		if (stagedValidation) validateStagedEvaluation(culled);
+		if (verbosity >= 2)
+			for (const auto &ind : population) printIndividualStats(ind);
+	}
+
+	// Full evaluation of the culled individuals, compared to their staged fitnesses:
+	// rank correlation over the population and proportion of random tournaments (as in
+	// multiObjTournament) whose winner stays the same.
+	void validateStagedEvaluation(const vector<size_t> &culled) {
+		vector<Individual<DNA>> full;
+		for (auto i : culled) full.push_back(Individual<DNA>(population[i].dna));
+#ifdef OMP
+#pragma omp parallel for schedule(dynamic, 2)
+#endif
+		for (size_t k = 0; k < full.size(); ++k) {
+			full[k].dna.reset();
+			evaluate(full[k]);
+		}
+		const string obj = stagedObjective.empty() ? population[0].fitnesses.begin()->first :
+		                                             stagedObjective;
+		vector<double> staged, exact;
+		double fullSimulatedTime = 0.0;
+		for (const auto &ind : population) {
+			staged.push_back(ind.fitnesses.at(obj));
+			exact.push_back(ind.fitnesses.at(obj));
+			if (!ind.wasAlreadyEvaluated && ind.evalStats.count("simulatedTime"))
+				fullSimulatedTime += ind.evalStats.at("simulatedTime");
+		}
+		for (size_t k = 0; k < culled.size(); ++k) {
+			exact[culled[k]] = full[k].fitnesses.at(obj);
+			if (full[k].evalStats.count("simulatedTime"))
+				fullSimulatedTime += full[k].evalStats.at("simulatedTime") -
+				                     population[culled[k]].evalStats.at("simulatedTime");
+		}
+		stagedStats["fullSimulatedTime"] = fullSimulatedTime;
+		stagedStats["rankCorrelation"] = rankCorrelation(staged, exact);
+		const unsigned int nbTournaments = 10000;
+		std::default_random_engine rnd(currentGeneration);
+		std::uniform_int_distribution<size_t> dint(0, population.size() - 1);
+		unsigned int same = 0;
+		for (unsigned int t = 0; t < nbTournaments; ++t) {
+			size_t w0 = dint(rnd), w1 = w0;
+			for (unsigned int i = 1; i < tournamentSize; ++i) {
+				size_t c = dint(rnd);
+				if (isBetter(staged[c], staged[w0])) w0 = c;
+				if (isBetter(exact[c], exact[w1])) w1 = c;
+			}
+			if (w0 == w1) ++same;
+		}
+		stagedStats["tournamentAgreement"] = static_cast<double>(same) / nbTournaments;
+	}
+
+	// Spearman correlation (average ranks for ties)
+	static double rankCorrelation(const vector<double> &a, const vector<double> &b) {
+		auto ranks = [](const vector<double> &v) {
+			vector<size_t> order(v.size());
+			for (size_t i = 0; i < v.size(); ++i) order[i] = i;
+			std::sort(order.begin(), order.end(),
+			          [&](size_t x, size_t y) { return v[x] < v[y]; });
+			vector<double> res(v.size());
+			for (size_t i = 0; i < order.size();) {
+				size_t j = i;
+				while (j + 1 < order.size() && v[order[j + 1]] == v[order[i]]) ++j;
+				for (size_t k = i; k <= j; ++k) res[order[k]] = 0.5 * (i + j);
+				i = j + 1;
+			}
+			return res;
+		};
+		const auto ra = ranks(a), rb = ranks(b);
+		const double n = a.size();
+		double ma = 0.0, mb = 0.0;
+		for (size_t i = 0; i < a.size(); ++i) {
+			ma += ra[i] / n;
+			mb += rb[i] / n;
+		}
+		double cov = 0.0, va = 0.0, vb = 0.0;
+		for (size_t i = 0; i < a.size(); ++i) {
+			cov += (ra[i] - ma) * (rb[i] - mb);
+			va += (ra[i] - ma) * (ra[i] - ma);
+			vb += (rb[i] - mb) * (rb[i] - mb);
+		}
+		return (va > 0 && vb > 0) ? cov / std::sqrt(va * vb) : 1.0;
+	}
+
 // MPI specifics
 #ifdef CLUSTER
 	void MPI_distributePopulation() {
@@ -481,6 +1713,7 @@ template <typename DNA, typename Evaluator> class GA {
 			if (d(globalRand) < crossoverProba) {
 				offspring = Individual<DNA>(p0->dna.crossover(p1->dna));
 				offspring.evaluated = false;
+				offspring.cost = 0.5 * (p0->cost + p1->cost);
 			} else {
 				offspring = *p0;
 			}
@@ -529,6 +1762,7 @@ template <typename DNA, typename Evaluator> class GA {
 			if (d(globalRand) < crossoverProba) {
 				offspring = Individual<DNA>(p0->dna.crossover(p1->dna));
 				offspring.evaluated = false;
+				offspring.cost = 0.5 * (p0->cost + p1->cost);
 			} else {
 				offspring = *p0;
 			}
@@ -575,7 +1809,8 @@ template <typename DNA, typename Evaluator> class GA {
 	/*********************************************************************************
 	 *                          NOVELTY RELATED METHODS
 	 ********************************************************************************/
-	// Novelty works with footprints. A footprint is just a vector of vector of doubles.
+	// Novelty works with footprints. A footprint is just a vector of vector of doubles
+	// (stored as a Footprint, packed when binary).
 	// It is recommended that those doubles are within a same order of magnitude.
 	// Each vector<double> is a "snapshot": it represents the state of the evaluation of
 	// one individual at a certain time. Thus, a complete footprint is a combination
@@ -584,62 +1819,47 @@ template <typename DNA, typename Evaluator> class GA {
 	// Snapshot must be of same size accross individuals.
 	// Footprint must be set in the evaluator (see examples)
 
-	static double getFootprintDistance(const fpType &f0, const fpType &f1) {
-		assert(f0.size() == f1.size());
-		double d = 0;
-		for (size_t i = 0; i < f0.size(); ++i) {
-			for (size_t j = 0; j < f0[i].size(); ++j) {
-				d += std::pow(f0[i][j] - f1[i][j], 2);
-			}
-		}
-		return sqrt(d);
+	// Binary footprints are compared with popcounts (see Footprint).
+	static double getFootprintDistance(const Footprint &f0, const Footprint &f1) {
+		return Footprint::distance(f0, f1);
 	}
 
 	// computeAvgDist (novelty related)
 	// returns the average distance of a footprint fp to its k nearest neighbours
-	// in an archive of footprints
-	static double computeAvgDist(unsigned int K, const vector<Individual<DNA>> &arch,
-	                             const fpType &fp) {
+	// in an archive of footprints (summed in increasing order)
+	static double computeAvgDist(unsigned int K, const FootprintMatrix &arch,
+	                             const Footprint &fp) {
 		double avgDist = 0;
 		if (arch.size() > 1) {
-			unsigned int k = arch.size() < K ? arch.size() : K;
-			vector<Individual<DNA>> knn;
-			knn.reserve(k);
 			vector<double> knnDist;
-			knnDist.reserve(k);
-			std::pair<double, size_t> worstKnn = {getFootprintDistance(fp, arch[0].footprint),
-			                                      0};  // maxKnn is the worst among the knn
-			for (unsigned int i = 0; i < k; ++i) {
-				knn.push_back(arch[i]);
-				double d = getFootprintDistance(fp, arch[i].footprint);
-				knnDist.push_back(d);
-				if (d > worstKnn.first) {
-					worstKnn = {d, i};
-				}
-			}
-			for (size_t i = k; i < arch.size(); ++i) {
-				double d = getFootprintDistance(fp, arch[i].footprint);
-				if (d < worstKnn.first) {  // this one is closer than our worst knn
-					knn[worstKnn.second] = arch[i];
-					knnDist[worstKnn.second] = d;
-					worstKnn.first = d;
-					// we update maxKnn
-					for (size_t j = 0; j < knn.size(); ++j) {
-						if (knnDist[j] > worstKnn.first) {
-							worstKnn = {knnDist[j], j};
-						}
-					}
-				}
-			}
-			assert(knn.size() == k);
-			for (size_t i = 0; i < knn.size(); ++i) {
-				assert(getFootprintDistance(fp, knn[i].footprint) == knnDist[i]);
-				avgDist += knnDist[i];
-			}
-			avgDist /= static_cast<double>(knn.size());
+			arch.nearest(fp, std::min<size_t>(K, arch.size()), knnDist);
+			for (auto d : knnDist) avgDist += d;
+			avgDist /= static_cast<double>(knnDist.size());
 		}
 		return avgDist;
 	}
+	// novelty of each individual of the population, whose footprint(i) are added to the
+	// archive's ones for the search (and removed after)
+	template <typename F>
+	vector<double> computeNovelty(FootprintMatrix &arch, const F &footprint) const {
+		// shapes are checked here, serially and before arch is changed: an exception must
+		// not escape the parallel loop
+		for (size_t i = 0; i < population.size(); ++i)
+			Footprint::checkShapes(arch.size() > 0 ? arch.getShape() : footprint(0).getShape(),
+			                       footprint(i).getShape());
+		const size_t archSize = arch.size();
+		arch.updateIndex(KNN);  // (not over the population, added below)
+		for (size_t i = 0; i < population.size(); ++i) arch.push_back(footprint(i));
+		vector<double> res(population.size());
+#ifdef OMP
+#pragma omp parallel for schedule(dynamic, 2)
+#endif
+		for (size_t i = 0; i < population.size(); ++i)
+			res[i] = computeAvgDist(KNN, arch, footprint(i));
+		arch.resize(archSize);
+		return res;
+	}
+
 	void updateNovelty() {
 		if (verbosity >= 2) {
 			cout << endl
@@ -649,17 +1869,57 @@ template <typename DNA, typename Evaluator> class GA {
 			     << endl
 			     << endl;
 		}
-		auto savedArchiveSize = archive.size();
-		for (auto &ind : population) {
-			archive.push_back(ind);
+		auto savedArchiveSize = archiveIds.size();
+		newlyArchived.clear();
+		projectionStats.clear();
+		auto t0 = high_resolution_clock::now();
+		vector<Footprint> projected;
+		if (projection.enabled()) {
+			// projections all have the same shape: the footprints' ones are checked before,
+			// serially (see computeNovelty)
+			for (const auto &ind : population)
+				Footprint::checkShapes(population[0].footprint.getShape(), ind.footprint.getShape());
+			projection.prepare(population[0].footprint);
+			projected.resize(population.size());
+#ifdef OMP
+#pragma omp parallel for schedule(dynamic, 8)
+#endif
+			for (size_t i = 0; i < population.size(); ++i)
+				projected[i] = projection(population[i].footprint);
+		}
+		auto exactFootprint = [&](size_t i) -> const Footprint & {
+			return population[i].footprint;
+		};
+		auto footprint = [&](size_t i) -> const Footprint & {
+			return projection.enabled() ? projected[i] : exactFootprint(i);
+		};
+		vector<double> noveltyScores = computeNovelty(archiveFootprints, footprint);
+		auto t1 = high_resolution_clock::now();
+		vector<double> exactNovelty;
+		if (projection.enabled() && projectionValidation) {
+			exactNovelty = computeNovelty(exactArchiveFootprints, exactFootprint);
+			auto t2 = high_resolution_clock::now();
+			projectionStats["time"] = std::chrono::duration<double>(t1 - t0).count();
+			projectionStats["exactTime"] = std::chrono::duration<double>(t2 - t1).count();
+			projectionStats["rankCorrelation"] = rankCorrelation(noveltyScores, exactNovelty);
+			size_t same = 0;  // same decision for the archive
+			for (size_t i = 0; i < population.size(); ++i)
+				if ((noveltyScores[i] > minNoveltyForArchive) ==
+				    (exactNovelty[i] > minNoveltyForArchive))
+					++same;
+			projectionStats["archiveAgreement"] =
+			    static_cast<double>(same) / static_cast<double>(population.size());
 		}
 		std::pair<Individual<DNA> *, double> best = {&population[0], 0};
-		vector<Individual<DNA>> toBeAdded;
-		for (auto &ind : population) {
-			double avgD = computeAvgDist(KNN, archive, ind.footprint);
+		for (size_t i = 0; i < population.size(); ++i) {
+			auto &ind = population[i];
+			double avgD = noveltyScores[i];
 			bool added = false;
 			if (avgD > minNoveltyForArchive) {
-				toBeAdded.push_back(ind);
+				newlyArchived.push_back(i);
+				archiveIds.push_back({currentGeneration, i});
+				archiveFootprints.push_back(footprint(i));
+				if (!exactNovelty.empty()) exactArchiveFootprints.push_back(ind.footprint);
 				added = true;
 			}
 			if (avgD > best.second) best = {&ind, avgD};
@@ -676,13 +1936,11 @@ template <typename DNA, typename Evaluator> class GA {
 			}
 			ind.fitnesses["novelty"] = avgD;
 		}
-		archive.resize(savedArchiveSize);
-		archive.insert(std::end(archive), std::begin(toBeAdded), std::end(toBeAdded));
 		if (verbosity >= 2) {
 			std::stringstream output;
-			output << " Added " << toBeAdded.size() << " new footprints to the archive."
+			output << " Added " << newlyArchived.size() << " new footprints to the archive."
 			       << std::endl
-			       << "New archive size = " << archive.size() << " (was " << savedArchiveSize
+			       << "New archive size = " << archiveIds.size() << " (was " << savedArchiveSize
 			       << ")." << std::endl;
 			std::cout << output.str() << std::endl;
 		}
@@ -695,9 +1953,9 @@ template <typename DNA, typename Evaluator> class GA {
 	}
 
 	// panpan cucul
-	static inline string footprintToString(const vector<vector<double>> &f) {
+	static inline string footprintToString(const Footprint &f) {
 		std::ostringstream res;
-		res << "👣  " << json(f).dump();
+		res << "👣  " << json(f.toVector()).dump();
 		return res.str();
 	}
 
@@ -728,9 +1986,30 @@ template <typename DNA, typename Evaluator> class GA {
 		if (novelty) {
 			std::cout << "  ▹ novelty is " << GREEN << "enabled" << NORMAL << std::endl;
 			std::cout << "    - KNN size = " << BLUE << KNN << NORMAL << std::endl;
+			if (projection.enabled())
+				std::cout << "    - projected to " << BLUE << projection.getDim() << NORMAL
+				          << " dimensions" << std::endl;
 		} else {
 			std::cout << "  ▹ novelty is " << RED << "disabled" << NORMAL << std::endl;
 		}
+		if (steadyState && nbProcs == 1) {
+			std::cout << "  ▹ steady state is " << GREEN << "enabled" << NORMAL << std::endl;
+			std::cout << "    - reports every " << BLUE
+			          << (steadyReportInterval > 0 ? steadyReportInterval : popSize) << NORMAL
+			          << " evaluations" << std::endl;
+		} else if (!stagedHorizons.empty()) {
+			if (hasStagedEvaluation<Evaluator, Individual<DNA>>::value) {
+				std::cout << "  ▹ staged evaluation is " << GREEN << "enabled" << NORMAL
+				          << std::endl;
+				std::cout << "    - horizons =" << BLUE;
+				for (auto h : stagedHorizons) std::cout << " " << h;
+				std::cout << NORMAL << ", kept = " << BLUE << stagedKeepProportion << NORMAL
+				          << std::endl;
+			} else {
+				std::cout << "  ▹ staged evaluation is " << RED
+				          << "not supported by the evaluator" << NORMAL << std::endl;
+			}
+		}
 #ifdef CLUSTER
 		std::cout << "  ▹ MPI parralelisation is " << GREEN << "enabled" << NORMAL
 		          << std::endl;
@@ -752,8 +2031,13 @@ template <typename DNA, typename Evaluator> class GA {
 	}
 	void updateStats(double totalTime) {
 		// stats organisations :
-		// "global" -> {"genTotalTime", "indTotalTime", "maxTime", "nEvals", "nObjs"}
+		// "global" -> {"genTotalTime", "indTotalTime", "maxTime", "nEvals", "nObjs",
+		//              "evalWallTime", "idleTime"} (see scheduleEvaluations)
 		// "obj_i" -> {"avg", "worst", "best"}
+		// "eval" -> sums of the individuals' evalStats (new evaluations only)
+		// "staged" -> see evaluatePopulation and validateStagedEvaluation
+		// "projection" -> see updateNovelty (when validating the novelty projection)
+		// "cache" -> see lookupEvaluations and cacheEvaluations
 		assert(population.size());
 		std::map<std::string, std::map<std::string, double>> currentGenStats;
 		currentGenStats["global"]["genTotalTime"] = totalTime;
@@ -775,9 +2059,20 @@ template <typename DNA, typename Evaluator> class GA {
 					currentGenStats[o.first].at("worst") = o.second;
 			}
 			if (ind.evalTime > maxTime) maxTime = ind.evalTime;
-			if (!ind.wasAlreadyEvaluated) ++nEvals;
+			if (!ind.wasAlreadyEvaluated) {
+				++nEvals;
+				for (const auto &s : ind.evalStats) currentGenStats["eval"][s.first] += s.second;
+			}
 		}
+		if (currentGenStats.count("eval") && currentGenStats["eval"].count("simulatedTime"))
+			totalSimulatedTime += currentGenStats["eval"]["simulatedTime"];
+		if (!stagedHorizons.empty() && hasStagedEvaluation<Evaluator, Individual<DNA>>::value)
+			currentGenStats["staged"] = stagedStats;
+		if (!projectionStats.empty()) currentGenStats["projection"] = projectionStats;
+		if (!cacheStats.empty()) currentGenStats["cache"] = cacheStats;
 		currentGenStats["global"]["indTotalTime"] = indTotalTime;
+		currentGenStats["global"]["evalWallTime"] = scheduleStats["evalWallTime"];
+		currentGenStats["global"]["idleTime"] = scheduleStats["idleTime"];
 		currentGenStats["global"]["maxTime"] = maxTime;
 		currentGenStats["global"]["nEvals"] = nEvals;
 		currentGenStats["global"]["nObjs"] = nObjs;
@@ -805,9 +2100,63 @@ template <typename DNA, typename Evaluator> class GA {
 		output << ", 🕝  sum: " << BLUEBOLD << globalStats.at("indTotalTime") << NORMAL
 		       << "s (x" << timeRatio << " ratio)";
 		std::cout << tableCenteredText(l, output.str(), CYANBOLD NORMAL BLUE NORMAL "      ");
+		output = std::ostringstream();
+		output << "evaluations: " << BLUE << globalStats.at("evalWallTime") << NORMAL
+		       << "s, threads idle: " << BLUE << globalStats.at("idleTime") << NORMAL << "s";
+		std::cout << tableCenteredText(l, output.str(), BLUE NORMAL BLUE NORMAL);
+		if (genStats[n].count("eval") && genStats[n].at("eval").count("simulatedTime")) {
+			output = std::ostringstream();
+			output << "simulated: " << BLUE << genStats[n].at("eval").at("simulatedTime")
+			       << NORMAL << "s (run total: " << BLUEBOLD << totalSimulatedTime << NORMAL
+			       << "s)";
+			std::cout << tableCenteredText(l, output.str(), BLUE NORMAL BLUEBOLD NORMAL);
+		}
+		if (genStats[n].count("eval") && genStats[n].at("eval").count("prescreenDead")) {
+			const auto &ev = genStats[n].at("eval");
+			output = std::ostringstream();
+			output << "prescreen: " << BLUE << ev.at("prescreenDead") << NORMAL
+			       << " dead at once, " << BLUE << ev.at("prescreenInert") << NORMAL
+			       << " predicted inert (" << BLUE << ev.at("prescreenInertConfirmed")
+			       << NORMAL << " right), " << BLUE << ev.at("prescreenTime") << NORMAL << "s";
+			std::cout << tableCenteredText(l, output.str(),
+			                               BLUE NORMAL BLUE NORMAL BLUE NORMAL BLUE NORMAL);
+		}
+		if (genStats[n].count("staged")) {
+			const auto &st = genStats[n].at("staged");
+			output = std::ostringstream();
+			output << "staged: " << BLUE << st.at("culled") << NORMAL << " culled";
+			if (st.count("tournamentAgreement"))
+				output << ", full eval: " << BLUE << st.at("fullSimulatedTime") << NORMAL
+				       << "s, rank corr: " << BLUE << st.at("rankCorrelation") << NORMAL
+				       << ", same winner: " << BLUE << 100.0 * st.at("tournamentAgreement")
+				       << NORMAL << "%";
+			std::cout << tableCenteredText(
+			    l, output.str(),
+			    st.count("tournamentAgreement") ? BLUE NORMAL BLUE NORMAL BLUE NORMAL BLUE NORMAL :
+			                                      BLUE NORMAL);
+		}
+		if (genStats[n].count("projection")) {
+			const auto &pr = genStats[n].at("projection");
+			output = std::ostringstream();
+			output << std::setprecision(3) << "projection: " << BLUE << pr.at("time") << NORMAL
+			       << "s (exact: " << BLUE << pr.at("exactTime") << NORMAL << "s), rank corr: "
+			       << BLUE << pr.at("rankCorrelation") << NORMAL << ", same archiving: " << BLUE
+			       << 100.0 * pr.at("archiveAgreement") << NORMAL << "%";
+			std::cout << tableCenteredText(l, output.str(),
+			                               BLUE NORMAL BLUE NORMAL BLUE NORMAL BLUE NORMAL);
+		}
+		if (genStats[n].count("cache")) {
+			const auto &ca = genStats[n].at("cache");
+			output = std::ostringstream();
+			output << "cache: " << BLUE << ca.at("hits") << NORMAL << " hits / "
+			       << ca.at("lookups") << " (" << BLUE << 100.0 * ca.at("hitRate") << NORMAL
+			       << "%), " << BLUE << ca.at("size") << NORMAL << " entries";
+			std::cout << tableCenteredText(l, output.str(), BLUE NORMAL BLUE NORMAL BLUE NORMAL);
+		}
 		std::cout << tableSeparation(l);
 		for (const auto &o : genStats[n]) {
-			if (o.first != "global") {
+			if (o.first != "global" && o.first != "eval" && o.first != "staged" &&
+			    o.first != "projection" && o.first != "cache") {
 				output = std::ostringstream();
 				output << GREYBOLD << "--◇" << GREENBOLD << std::setw(10) << o.first << GREYBOLD
 				       << " ❯ " << NORMAL << " worst: " << YELLOW << std::setw(12)
@@ -1000,18 +2349,21 @@ template <typename DNA, typename Evaluator> class GA {
 		file << o.dump();
 		file.close();
 	}
+	// Appends the individuals archived this generation to folder/archive.jsonl, one json
+	// object per line (readable as an Individual), every generation.
 	void saveArchive() {
-		json o = Individual<DNA>::popToJSON(archive);
+		for (auto i : newlyArchived) appendToArchive(population[i], currentGeneration, i);
+	}
+	void appendToArchive(const Individual<DNA> &ind, unsigned int generation, size_t index) {
+		std::ofstream file(folder + "/archive.jsonl", std::ios::app);
+		json o;
+		o["generation"] = generation;
+		o["index"] = index;
 		o["evaluator"] = evaluate.name;
-		std::stringstream baseName;
-		baseName << folder << "/gen" << currentGeneration;
-		mkdir(baseName.str().c_str(), 0777);
-		std::stringstream fileName;
-		fileName << baseName.str() << "/archive" << currentGeneration << ".pop";
-		std::ofstream file;
-		file.open(fileName.str());
-		file << o.dump();
-		file.close();
+		o["dna"] = json::parse(ind.dna.toJSON());
+		o["footprint"] = ind.footprint.toVector();
+		o["fitnesses"] = ind.fitnesses;
+		file << o.dump() << "\n";
 	}
 };
 }  // namespace GAGA
@@ -2,6 +2,7 @@
 #define GENERICGRN_HPP
 #include <assert.h>
 #include <array>
+#include <cstdint>
 #include <map>
 #include <unordered_map>
 #include <string>
@@ -389,6 +390,30 @@ template <typename Implem> class GRN {
 		return o.dump(2);
 	}
 
+	// 64 bits FNV-1a hash of what determines the GRN's behavior: its params and, for each
+	// type, its proteins in name order (which is their order in actualProteins, see
+	// updateSignatures) with their names and coords. Concentrations are left out, as they
+	// are all reset before a run. Equal GRNs have equal hashes whatever the mutations and
+	// crossovers that led to them.
+	uint64_t canonicalHash() const {
+		uint64_t h = 14695981039346656037ull;
+		auto add = [&](const void* data, size_t n) {
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			for (size_t i = 0; i < n; ++i) h = (h ^ bytes[i]) * 1099511628211ull;
+		};
+		for (auto p : params) add(&p, sizeof(p));
+		for (const auto& t : proteinsRefs) {
+			const uint64_t n = t.size();
+			add(&n, sizeof(n));
+			for (const auto& p : t) {
+				add(p.first.c_str(), p.first.size() + 1);
+				const auto& prot = actualProteins[p.second];
+				for (const auto& c : prot.coords) add(&c, sizeof(c));
+			}
+		}
+		return h;
+	}
+
 	std::string typeToString(ProteinType t) const {
 		switch (t) {
 			case ProteinType::input:
@@ -0,0 +1,111 @@
+#include "external/gaga/gaga/gaga.hpp"
+#include "external/cxxopts.hpp"
+#include "core/evaluators.hpp"
+#include "core/scenariooptions.hpp"
+#include "core/typesconfig.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <malloc.h>
+
+// bytes in use on glibc's heap (mallinfo2 only exists since glibc 2.33; the int fields
+// of mallinfo are enough for one cell)
+size_t heapInUse() {
+#if __GLIBC_PREREQ(2, 33)
+	return mallinfo2().uordblks;
+#else
+	return static_cast<size_t>(mallinfo().uordblks);
+#endif
+}
+
+// Memory footprint of a cell: its own size and what a copy (i.e. a division)
+// allocates on the heap. The heap part is the growth of glibc's in-use bytes while
+// the copy is alive, so it includes malloc's per-block overhead. Only meaningful
+// when no other thread allocates, which is the case here (it runs before any
+// evaluation).
+template <typename Cell> void memoryAudit(const Cell &model) {
+	const size_t before = heapInUse();
+	size_t heapBytes = 0;
+	{
+		Cell copy(model);
+		heapBytes = heapInUse() - before;
+	}
+	std::cout << "sizeof(Cell) = " << sizeof(Cell) << " B, sizeof(Controller) = "
+	          << sizeof(typename Cell::CtrlType) << " B, heap per cell = " << heapBytes
+	          << " B, total per cell = " << sizeof(Cell) + heapBytes << " B" << std::endl;
+}
+
+// Evaluation throughput of one GA generation: a population is evaluated the same way
+// GAGA does it (one evaluation per OpenMP thread at a time) and the wall time is reported.
+// The population is made of random genomes or, with -f, of mutants of the same genome.
+// Compare builds (e.g. with and without -DNO_BLOCK_POOL) on the same seed.
+int main(int argc, char** argv) {
+	using scenario_t = TypesConfig::ScenarioType;
+	using ctrl_t = TypesConfig::CtrlType;
+
+	unsigned int popSize = 200;
+	unsigned int seed = 0;
+	unsigned int nbRuns = 1;
+	bool audit = false;
+	ScenarioOptions scenarioOptions;
+	try {
+		cxxopts::Options options(argv[0]);
+		options.add_options("bench")("p,popsize", "number of evaluations per run",
+		                             cxxopts::value<unsigned int>(popSize));
+		options.add_options("bench")("s,seed", "grn random seed",
+		                             cxxopts::value<unsigned int>(seed));
+		options.add_options("bench")("n,runs", "number of runs",
+		                             cxxopts::value<unsigned int>(nbRuns));
+		options.add_options("bench")("audit", "only report the memory used by a cell",
+		                             cxxopts::value<bool>(audit));
+		scenarioOptions.addOptions(options);
+		options.parse(argc, argv);
+	} catch (const cxxopts::OptionException& e) {
+		std::cout << "error parsing options: " << e.what() << std::endl;
+		exit(1);
+	} catch (const std::bad_cast& e) {
+		std::cout << "bad cast: " << e.what() << std::endl;
+		exit(1);
+	}
+	grnRand.seed(seed);
+	std::vector<GAGA::Individual<ctrl_t>> population;
+	if (scenarioOptions.stemFile.empty()) {
+		for (auto i = 0u; i < popSize; ++i)
+			population.push_back(GAGA::Individual<ctrl_t>(ctrl_t::random(argc, argv)));
+	} else {
+		std::ifstream fstr(scenarioOptions.stemFile);
+		std::stringstream buffer;
+		buffer << fstr.rdbuf();
+		ctrl_t original(buffer.str());
+		for (auto i = 0u; i < popSize; ++i) {
+			ctrl_t mutant(original);
+			if (i > 0) mutant.mutate();
+			population.push_back(GAGA::Individual<ctrl_t>(mutant));
+		}
+	}
+
+	if (audit) {
+		memoryAudit(TypesConfig::CellType(population[0].dna));
+		return 0;
+	}
+
+	SurvivalEvaluator<scenario_t> evaluate(1, argv);
+	evaluate.options = scenarioOptions;
+	for (auto r = 0u; r < nbRuns; ++r) {
+		auto t0 = std::chrono::high_resolution_clock::now();
+#ifdef OMP
+#pragma omp parallel for schedule(dynamic, 2)
+#endif
+		for (size_t i = 0; i < population.size(); ++i) evaluate(population[i]);
+		auto t1 = std::chrono::high_resolution_clock::now();
+		double wallTime = std::chrono::duration<double>(t1 - t0).count();
+		double totalSimTime = 0.0;
+		for (const auto& ind : population) totalSimTime += ind.fitnesses.at("Survival");
+		std::cout << "run " << r << ": " << population.size() << " evaluations in "
+		          << std::setprecision(4) << wallTime << "s ("
+		          << population.size() / wallTime << " evals/s, " << totalSimTime / wallTime
+		          << " simulated s/s)" << std::endl;
+	}
+	return 0;
+}
@@ -1,18 +1,336 @@
 #include <mecacell/mecacell.h>
 #include "core/typesconfig.hpp"
+#include "core/capture.hpp"
+#include "core/scenariooptions.hpp"
+#include "core/snapshot.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 
-int main(int argc, char *argv[]) {
-	TypesConfig::ScenarioType sc;
-	sc.init(argc, argv);
-	while (!sc.finished()) {
+struct RunSummary {
+	double survival = 0.0;
+	size_t maxCells = 0;
+	size_t finalCells = 0;
+	double cellUpdates = 0.0;      // sum over steps of the number of cells
+	double sleepingUpdates = 0.0;  // same, for sleeping cells
+	double wallTime = 0.0;
+};
+
+// runs until the end of the simulation or until simTime reaches until
+template <typename S>
+RunSummary run(S &sc, bool verbose,
+               double until = std::numeric_limits<double>::infinity()) {
+	RunSummary r;
+	const bool sleeping = sc.getOptions().sleeping;
+	auto t0 = std::chrono::high_resolution_clock::now();
+	while (!sc.finished() && sc.simTime < until) {
 		sc.loop();
-		std::cout << "updt " << sc.getWorld().getNbUpdates() << ", "
-		          << sc.getWorld().cells.size() << " cells" << std::endl;
-		int i = 0;
-		// for (auto &n : sc.nutrientSources) {
-		// std::cerr << " N " << i++ << " : content = " << n.content << std::endl;
-		//}
+		const size_t nbCells = sc.getWorld().cells.size();
+		const size_t nbSleeping = sleeping ? sc.getNbSleepingCells() : 0;
+		r.maxCells = std::max(r.maxCells, nbCells);
+		r.cellUpdates += nbCells;
+		r.sleepingUpdates += nbSleeping;
+		if (verbose) {
+			std::cout << "updt " << sc.getWorld().getNbUpdates() << ", " << nbCells << " cells";
+			if (sleeping)
+				std::cout << " (" << nbCells - nbSleeping << " awake, " << nbSleeping
+				          << " asleep)";
+			std::cout << std::endl;
+		}
 	}
 	sc.terminate();
+	auto t1 = std::chrono::high_resolution_clock::now();
+	r.survival = sc.simTime;
+	r.finalCells = sc.getWorld().cells.size();
+	r.wallTime = std::chrono::duration<double>(t1 - t0).count();
+	return r;
+}
+
+// hash of the cells' state with their connections, nutrient sources and time (the two
+// cells of a connection are in the order of their addresses, which only a restore keeps)
+template <typename S> uint64_t stateDigest(const S &sc) {
+	std::ostringstream os;
+	SnapshotWriter out(os);
+	out(sc.simTime);
+	out(sc.nutrientContent);
+	for (const auto &c : sc.getWorld().cells) {
+		c->saveState(out);
+		for (const auto *con : c->getMembrane().getCellCellConnectionManager().cellConnections) {
+			out(static_cast<uint64_t>(std::min(con->cells.first->slot, con->cells.second->slot)));
+			out(static_cast<uint64_t>(std::max(con->cells.first->slot, con->cells.second->slot)));
+			out(static_cast<double>(con->area));
+			out(static_cast<double>(con->adhArea));
+			out(static_cast<double>(con->centersDist));
+			out(static_cast<double>(con->adhCoef));
+		}
+	}
+	uint64_t h = 14695981039346656037ULL;  // FNV-1a
+	for (unsigned char ch : os.str()) h = (h ^ ch) * 1099511628211ULL;
+	return h;
+}
+
+// Round trip check: the simulation is saved at time t, restored in another scenario,
+// and both are run side by side until the end.
+template <typename S> void checkSnapshot(S &sc, double t) {
+	S fork;
+	fork.setStemCell(new typename S::CellType(*sc.getStemCell()));
+	fork.init(sc.getOptions());
+	auto t0 = std::chrono::high_resolution_clock::now();
+	run(sc, false, t);
+	auto t1 = std::chrono::high_resolution_clock::now();
+	std::stringstream snapshot;
+	sc.save(snapshot);
+	auto t2 = std::chrono::high_resolution_clock::now();
+	if (!fork.restore(snapshot)) exit(1);
+	auto t3 = std::chrono::high_resolution_clock::now();
+	const size_t nbCells = sc.getWorld().cells.size();
+	size_t nbSteps = 0, nbIdentical = 0;
+	bool diverged = stateDigest(sc) != stateDigest(fork);
+	double divergenceTime = diverged ? sc.simTime : 0.0;
+	while (!sc.finished() || !fork.finished()) {
+		if (!sc.finished()) sc.loop();
+		if (!fork.finished()) fork.loop();
+		++nbSteps;
+		if (!diverged && stateDigest(sc) == stateDigest(fork)) {
+			++nbIdentical;
+		} else if (!diverged) {
+			diverged = true;
+			divergenceTime = sc.simTime;
+		}
+	}
+	auto ms = [](decltype(t0) a, decltype(t0) b) {
+		return std::chrono::duration<double, std::milli>(b - a).count();
+	};
+	std::cout << "snapshot at t = " << t << ": " << nbCells << " cells, "
+	          << snapshot.str().size() << " B, saved in " << ms(t1, t2)
+	          << "ms, restored in " << ms(t2, t3) << "ms (simulated in " << ms(t0, t1)
+	          << "ms)" << std::endl;
+	std::cout << "identical steps after restore: " << nbIdentical << " / " << nbSteps;
+	if (diverged) std::cout << " (first difference at t = " << divergenceTime << ")";
+	std::cout << std::endl;
+	std::cout << "survival: " << sc.simTime << " | restored: " << fork.simTime << std::endl;
+	std::cout << "final cells: " << sc.getWorld().cells.size()
+	          << " | restored: " << fork.getWorld().cells.size() << std::endl;
+	if (diverged) exit(1);
+}
+
+// Births and deaths reported to the observers, checked against the number of cells after
+// each step: the stem cell plus the births, minus the deaths.
+template <typename S> void checkBirths(S &sc) {
+	struct Counter : public ScenarioObserver<typename S::CellType> {
+		size_t births = 0, deaths = 0;
+		void onBirth(const typename S::CellType &) override { ++births; }
+		void onDeath(const typename S::CellType &) override { ++deaths; }
+	} counter;
+	sc.addObserver(&counter);
+	size_t firstBirths = 0;
+	double firstDivision = -1.0;
+	bool consistent = true;
+	while (!sc.finished() && consistent) {
+		const size_t before = sc.getWorld().cells.size(), births = counter.births;
+		sc.loop();
+		if (sc.getWorld().cells.size() > before && firstDivision < 0.0) {
+			firstDivision = sc.simTime;
+			firstBirths = counter.births - births;
+		}
+		consistent = 1 + counter.births == sc.getWorld().cells.size() + counter.deaths;
+	}
+	if (firstDivision >= 0.0)
+		std::cout << "first division at t = " << firstDivision << ": " << firstBirths
+		          << " birth(s) reported" << std::endl;
+	std::cout << "births: " << counter.births << ", deaths: " << counter.deaths
+	          << ", final cells: " << sc.getWorld().cells.size() << " (at t = " << sc.simTime
+	          << ")" << std::endl;
+	if (!consistent || (firstDivision >= 0.0 && firstBirths == 0)) {
+		std::cout << "births and deaths do not add up to the number of cells" << std::endl;
+		exit(1);
+	}
+}
+
+// Pixel per pixel reference of ClusterTools::getMatrixCapture: every subpixel of the
+// grid is tested against every disk of the same layout.
+template <int FinalW, int FinalH, typename Cell>
+std::array<std::array<double, FinalW>, FinalH> referenceCapture(
+    const std::vector<Cell *> &cells, bool binary, double maxWidth) {
+	constexpr int os = ClusterTools::CAPTURE_OVERSAMPLING;
+	const auto layout = ClusterTools::getCaptureLayout<os * FinalW, os * FinalH>(cells, maxWidth);
+	std::array<std::array<int, FinalW>, FinalH> covered = {};
+	for (const auto &d : layout.disks)
+		for (int j = 0; j < os * FinalH; ++j)
+			for (int i = 0; i < os * FinalW; ++i)
+				if (layout.covers(d, i, j)) ++covered[j / os][i / os];
+	return ClusterTools::downscaleCapture<FinalW, FinalH>(covered, binary);
+}
+
+// differing pixels between the scanline and the reference capture of these cells
+template <int W, int H, typename Cell>
+size_t compareCaptures(const std::string &name, const std::vector<Cell *> &cells, bool binary,
+                       double maxWidth) {
+	const auto a = ClusterTools::getMatrixCapture<W, H>(cells, binary, maxWidth);
+	const auto b = referenceCapture<W, H>(cells, binary, maxWidth);
+	size_t res = 0;
+	for (int l = 0; l < H; ++l)
+		for (int c = 0; c < W; ++c)
+			if (a[l][c] != b[l][c]) ++res;
+	std::cout << " " << name << ": " << (res ? std::to_string(res) + " pixels differ" : "identical")
+	          << std::endl;
+	return res;
+}
+
+// Capture of a fixed L shaped layout, against the one stored here (covered subpixels
+// per pixel, in base 36). Catches changes of the projection or orientation, which the comparison
+// with the reference cannot see.
+size_t checkFixedCapture() {
+	struct FixedCell {
+		MecaCell::Vec p;
+		double r;
+		const MecaCell::Vec &getPosition() const { return p; }
+		double getBoundingBoxRadius() const { return r; }
+	};
+	std::vector<FixedCell> layout;
+	for (int k = 0; k < 6; ++k) layout.push_back({MecaCell::Vec(10.0 * k, 0, 0), 6.0});
+	for (int k = 1; k < 3; ++k) layout.push_back({MecaCell::Vec(0, 10.0 * k, 0), 4.0});
+	std::vector<FixedCell *> cells;
+	for (auto &c : layout) cells.push_back(&c);
+	const std::array<std::string, 12> expected = {{
+	    "000000000000",
+	    "000000000000",
+	    "000000000000",
+	    "000000001000",
+	    "000002598000",
+	    "00026a967100",
+	    "049b84103200",
+	    "066200002300",
+	    "000000000000",
+	    "000000000000",
+	    "000000000000",
+	    "000000000000",
+	}};
+	const auto capture = ClusterTools::getMatrixCapture<12, 12>(cells, false, 0.0);
+	size_t res = 0;
+	for (int l = 0; l < 12; ++l) {
+		std::string row;
+		for (int c = 0; c < 12; ++c) {
+			const long k = std::lround(capture[l][c] * 9.0);  // (> 9 where cells overlap)
+			row += k < 10 ? static_cast<char>('0' + k) : static_cast<char>('a' + k - 10);
+		}
+		if (row != expected[l]) {
+			std::cout << "  row " << l << ": " << row << " instead of " << expected[l] << std::endl;
+			++res;
+		}
+	}
+	std::cout << " 12x12, fixed layout: "
+	          << (res ? std::to_string(res) + " rows differ" : "identical") << std::endl;
+	return res;
+}
+
+// captures taken by the evaluators, at time t (or at the end of the run)
+template <typename S> void checkCaptures(S &sc, double t) {
+	run(sc, false, t);
+	const auto &cells = sc.getWorld().cells;
+	const auto biggest =
+	    ClusterTools::getBiggestCluster(cells, sc.getWorld().cellCellConnections);
+	std::cout << "captures of " << cells.size() << " cells at t = " << sc.simTime << ":"
+	          << std::endl;
+	size_t nbDiff = checkFixedCapture();
+	nbDiff += compareCaptures<15, 15>("15x15, 500 wide", cells, false, 500.0);
+	nbDiff += compareCaptures<17, 17>("17x17, auto scaled", cells, false, 0.0);
+	nbDiff += compareCaptures<30, 30>("30x30, biggest cluster, binary", biggest, true, 0.0);
+	if (nbDiff) exit(1);
+}
+
+int main(int argc, char *argv[]) {
+	ScenarioOptions scenarioOptions;
+	std::string resumeFile, snapshotFile = "snapshot.bin";
+	double snapshotTime = -1.0, checkTime = -1.0;
+	double checkCaptureTime = -1.0;
+	bool checkBirthsRun = false;
+	try {
+		cxxopts::Options options(argv[0]);
+		scenarioOptions.addOptions(options);
+		options.add_options("snapshot")("resume", "start from a snapshot file",
+		                                cxxopts::value<std::string>(resumeFile));
+		options.add_options("snapshot")("snapshot-at", "save a snapshot at this time",
+		                                cxxopts::value<double>(snapshotTime));
+		options.add_options("snapshot")("snapshot-file", "where to save the snapshot",
+		                                cxxopts::value<std::string>(snapshotFile));
+		options.add_options("snapshot")(
+		    "check-snapshot",
+		    "save a snapshot at this time, restore it in another scenario and check that both "
+		    "runs stay identical",
+		    cxxopts::value<double>(checkTime));
+		options.add_options()(
+		    "check-capture",
+		    "compare the captures at this time with the pixel per pixel reference "
+		    "rasterization, and a fixed layout with its stored capture",
+		    cxxopts::value<double>(checkCaptureTime));
+		options.add_options()(
+		    "check-births",
+		    "check that the births and deaths reported to observers add up to the number of cells",
+		    cxxopts::value<bool>(checkBirthsRun));
+		options.parse(argc, argv);
+	} catch (const cxxopts::OptionException &e) {
+		std::cout << "error parsing options: " << e.what() << std::endl;
+		exit(1);
+	} catch (const std::bad_cast &e) {
+		std::cout << "bad cast: " << e.what() << std::endl;
+		exit(1);
+	}
+	TypesConfig::ScenarioType sc;
+	if (!resumeFile.empty() && scenarioOptions.stemFile.empty())
+		scenarioOptions.randomStem = true;  // (replaced by the snapshot's)
+	sc.init(scenarioOptions);
+	if (!resumeFile.empty()) {
+		std::ifstream fstr(resumeFile, std::ios::binary);
+		if (!sc.restore(fstr)) exit(1);
+	}
+	if (checkTime >= 0.0) {
+		checkSnapshot(sc, checkTime);
+		return 0;
+	}
+	if (checkCaptureTime >= 0.0) {
+		checkCaptures(sc, checkCaptureTime);
+		return 0;
+	}
+	if (checkBirthsRun) {
+		checkBirths(sc);
+		return 0;
+	}
+	if (snapshotTime >= 0.0) {
+		run(sc, true, snapshotTime);
+		std::ofstream fstr(snapshotFile, std::ios::binary);
+		sc.save(fstr);
+		std::cout << "snapshot saved to " << snapshotFile << " at t = " << sc.simTime
+		          << std::endl;
+	}
+	if (!sc.getOptions().validate) {
+		run(sc, true);
+		return 0;
+	}
+	// validation: same stem cell, without any approximation
+	TypesConfig::ScenarioType ref;
+	ref.setStemCell(new TypesConfig::CellType(*sc.getStemCell()));
+	ref.init(sc.getOptions().exact());
+	auto r = run(sc, false);
+	auto f = run(ref, false);
+	std::cout << "rates: " << sc.scheduler.toString()
+	          << ", sleep: " << (sc.getOptions().sleeping ? "on" : "off") << std::endl;
+	std::cout << "               approximate | exact" << std::endl;
+	std::cout << " survival    : " << std::setw(11) << r.survival << " | " << f.survival
+	          << " (drift = " << r.survival - f.survival << ", "
+	          << (f.survival > 0 ? 100.0 * (r.survival - f.survival) / f.survival : 0.0)
+	          << "%)" << std::endl;
+	std::cout << " max cells   : " << std::setw(11) << r.maxCells << " | " << f.maxCells
+	          << std::endl;
+	std::cout << " final cells : " << std::setw(11) << r.finalCells << " | " << f.finalCells
+	          << std::endl;
+	std::cout << " asleep      : " << std::setw(10)
+	          << (r.cellUpdates > 0 ? 100.0 * r.sleepingUpdates / r.cellUpdates : 0.0)
+	          << "% | 0%" << std::endl;
+	std::cout << " wall time   : " << std::setw(11) << r.wallTime << " | " << f.wallTime
+	          << " (x" << (r.wallTime > 0 ? f.wallTime / r.wallTime : 0.0) << ")" << std::endl;
 	return 0;
 }
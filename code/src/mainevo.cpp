@@ -1,9 +1,44 @@
 #include "external/gaga/gaga/gaga.hpp"
 #include "external/cxxopts.hpp"
 #include "core/evaluators.hpp"
+#include "core/scenariooptions.hpp"
 #include "core/typesconfig.hpp"
 
-template <typename GA> int launchGA(GA&& evo) {
+// successive halving (see GAGA::GA::setStagedEvaluation)
+struct StagedSettings {
+	std::vector<double> horizons;
+	double keep = 0.5;
+	bool check = false;
+};
+
+// novelty on random projections of the footprints (see GAGA::GA::setNoveltyProjection)
+struct ProjectionSettings {
+	size_t dim = 0;  // 0 = exact novelty
+	unsigned int seed = 0;
+	bool check = false;
+};
+
+// evaluations of already seen genomes (see GAGA::GA::setEvaluationCache)
+struct CacheSettings {
+	size_t capacity = 0;  // 0 = no cache
+	std::string file;     // kept between runs
+};
+
+// asynchronous steady state instead of generations (see GAGA::GA::setSteadyState)
+struct SteadyStateSettings {
+	bool enabled = false;
+	unsigned int reportInterval = 0;  // evaluations per "generation" (0 = population size)
+};
+
+template <typename GA>
+int launchGA(GA&& evo, const ScenarioOptions& scenarioOptions, const StagedSettings& staged,
+             const ProjectionSettings& projection, const CacheSettings& cache,
+             const SteadyStateSettings& steady) {
+	evo.getEvaluator().options = scenarioOptions;
+	evo.setStagedEvaluation(staged.horizons, staged.keep, "", staged.check);
+	evo.setNoveltyProjection(projection.dim, projection.seed, projection.check);
+	evo.setEvaluationCache(cache.capacity, cache.file, scenarioOptions.fingerprint());
+	evo.setSteadyState(steady.enabled, steady.reportInterval);
 	evo.setVerbosity(2);
 	evo.setPopSize(200);
 	evo.setNbGenerations(400);
@@ -18,10 +53,43 @@ int main(int argc, char** argv) {
 	using ctrl_t = TypesConfig::CtrlType;
 
 	std::string evaluatorName;
+	ScenarioOptions scenarioOptions;
+	StagedSettings staged;
+	ProjectionSettings projection;
+	CacheSettings cache;
+	SteadyStateSettings steady;
 	try {
 		cxxopts::Options options(argv[0]);
 		options.add_options()("e,evaluator", "evaluator name",
 		                      cxxopts::value<std::string>(evaluatorName));
+		options.add_options("staged")(
+		    "rung", "staged evaluation horizon (repeat for several rungs)",
+		    cxxopts::value<std::vector<double>>(staged.horizons));
+		options.add_options("staged")("keep", "proportion going on at each rung",
+		                              cxxopts::value<double>(staged.keep));
+		options.add_options("staged")(
+		    "check-staged", "also fully evaluate culled individuals and report the changes",
+		    cxxopts::value<bool>(staged.check));
+		options.add_options("novelty")("novelty-dim",
+		                               "project footprints to this many dimensions for novelty",
+		                               cxxopts::value<size_t>(projection.dim));
+		options.add_options("novelty")("novelty-seed", "seed of the projection",
+		                               cxxopts::value<unsigned int>(projection.seed));
+		options.add_options("novelty")(
+		    "check-novelty", "also compute the exact novelty and report the rank agreement",
+		    cxxopts::value<bool>(projection.check));
+		options.add_options("cache")("cache", "evaluations of seen genomes kept (LRU)",
+		                             cxxopts::value<size_t>(cache.capacity));
+		options.add_options("cache")(
+		    "cache-file",
+		    "evaluation cache kept between runs (entries made with other settings are ignored)",
+		    cxxopts::value<std::string>(cache.file));
+		options.add_options("steady")("steady",
+		                              "asynchronous steady state instead of generations",
+		                              cxxopts::value<bool>(steady.enabled));
+		options.add_options("steady")("report-every", "evaluations between stats and saves",
+		                              cxxopts::value<unsigned int>(steady.reportInterval));
+		scenarioOptions.addOptions(options);
 		options.parse(argc, argv);
 	} catch (const cxxopts::OptionException& e) {
 		std::cout << "error parsing options: " << e.what() << std::endl;
@@ -31,30 +99,31 @@ int main(int argc, char** argv) {
 		exit(1);
 	}
 	if (evaluatorName == "survival")
-		return launchGA(GAGA::GA<ctrl_t, SurvivalEvaluator<scenario_t>>(argc, argv));
+		return launchGA(GAGA::GA<ctrl_t, SurvivalEvaluator<scenario_t>>(argc, argv),
+		                scenarioOptions, staged, projection, cache, steady);
 	if (evaluatorName == "survival_novelty_only") {
 		GAGA::GA<ctrl_t, SurvivalNoveltyOnlyEvaluator<scenario_t>> evo(argc, argv);
 		evo.enableNovelty();
 		evo.setMinNoveltyForArchive(0.1);
-		return launchGA(evo);
+		return launchGA(evo, scenarioOptions, staged, projection, cache, steady);
 	}
 	if (evaluatorName == "survival_and_novelty") {
 		GAGA::GA<ctrl_t, SurvivalAndNoveltyEvaluator<scenario_t>> evo(argc, argv);
 		evo.enableNovelty();
 		evo.setMinNoveltyForArchive(0.1);
-		return launchGA(evo);
+		return launchGA(evo, scenarioOptions, staged, projection, cache, steady);
 	}
 	if (evaluatorName == "survival_and_capture") {
 		GAGA::GA<ctrl_t, SurvivalAndCaptureEvaluator<scenario_t>> evo(argc, argv);
 		evo.enableNovelty();
 		evo.setMinNoveltyForArchive(3.0);
-		return launchGA(evo);
+		return launchGA(evo, scenarioOptions, staged, projection, cache, steady);
 	}
 	if (evaluatorName == "survival_multinovelty") {
 		GAGA::GA<ctrl_t, SurvivalAndMultiNoveltyEvaluator<scenario_t>> evo(argc, argv);
 		evo.enableNovelty();
 		evo.setMinNoveltyForArchive(1.0);
-		return launchGA(evo);
+		return launchGA(evo, scenarioOptions, staged, projection, cache, steady);
 	}
 
 	std::cerr << "No valid evaluator found, aborting." << std::endl;
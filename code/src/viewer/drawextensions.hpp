@@ -263,11 +263,13 @@ class Nutrients {
 		texture->bind(0);
 		shader.setUniformValue(shader.uniformLocation("projection"), projection);
 		shader.setUniformValue(shader.uniformLocation("view"), view);
-		for (auto &n : r->getScenario().nutrientSources) {
+		const auto &sc = r->getScenario();
+		const auto &layout = *sc.nutrientLayout;
+		for (size_t n = 0; n < layout.size(); ++n) {
 			QMatrix4x4 model;
-			model.translate(n.pos.x(), n.pos.y(), n.pos.z());
-			double c = n.content / n.initialcontent;
-			double l = 15.0 + sqrt(n.sqradius * c) * 0.05;
+			model.translate(layout.pos[n].x(), layout.pos[n].y(), layout.pos[n].z());
+			double c = sc.nutrientContent[n] / layout.initialContent[n];
+			double l = 15.0 + sqrt(layout.sqradius[n] * c) * 0.05;
 			model.scale(l, l, l);
 			QMatrix4x4 nmatrix = (model).inverted().transposed();
 			shader.setUniformValue(shader.uniformLocation("model"), model);